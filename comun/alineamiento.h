@@ -0,0 +1,678 @@
+// Codigo compartido por los laboratorios de alineamiento. Cada laboratorio sigue siendo un solo archivo
+// que se compila por separado; lo que es identico entre ellos vive aqui para que una correccion se haga
+// una sola vez.
+#ifndef COMUN_ALINEAMIENTO_H
+#define COMUN_ALINEAMIENTO_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <immintrin.h>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Despacho de kernels vectoriales: lo que soporta la CPU se detecta una sola vez y cada familia de
+// kernels enlaza su variante a partir de nivelSIMD(). Para pruebas, la variable de entorno
+// BIOINF_SIMD=escalar|avx2|avx512 fuerza un nivel (nunca uno que la CPU no tenga).
+enum class NivelSIMD { ESCALAR, AVX2, AVX512 };
+
+inline const char *nombreNivelSIMD(NivelSIMD nivel) {
+  switch (nivel) {
+  case NivelSIMD::AVX512:
+    return "avx512";
+  case NivelSIMD::AVX2:
+    return "avx2";
+  default:
+    return "escalar";
+  }
+}
+
+inline NivelSIMD nivelSIMDSoportado() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    return NivelSIMD::AVX512;
+  if (__builtin_cpu_supports("avx2"))
+    return NivelSIMD::AVX2;
+  return NivelSIMD::ESCALAR;
+}
+
+inline NivelSIMD nivelSIMD() {
+  static const NivelSIMD nivel = [] {
+    NivelSIMD soportado = nivelSIMDSoportado();
+    const char *forzado = getenv("BIOINF_SIMD");
+    if (forzado == nullptr || *forzado == '\0')
+      return soportado;
+    string valor = forzado;
+    NivelSIMD pedido;
+    if (valor == "escalar") {
+      pedido = NivelSIMD::ESCALAR;
+    } else if (valor == "avx2") {
+      pedido = NivelSIMD::AVX2;
+    } else if (valor == "avx512") {
+      pedido = NivelSIMD::AVX512;
+    } else {
+      cerr << "BIOINF_SIMD desconocido: " << valor << " (se usa " << nombreNivelSIMD(soportado) << ")" << endl;
+      return soportado;
+    }
+    if (pedido > soportado) {
+      cerr << "La CPU no soporta " << valor << " (se usa " << nombreNivelSIMD(soportado) << ")" << endl;
+      return soportado;
+    }
+    return pedido;
+  }();
+  return nivel;
+}
+
+// Parámetros de puntuacion por defecto
+const int MATCH = 1;
+const int MISMATCH = -1;
+const int GAP = -2;
+const int MENOS_INFINITO = numeric_limits<int>::min() / 2;
+
+// Politicas de puntuacion. Se pasan como parametro de plantilla a los kernels, asi los valores son
+// constantes de compilacion y el lazo interno queda tan rapido como con MATCH/MISMATCH/GAP fijos.
+// Un gap de longitud L cuesta apertura + L * extension (las politicas lineales tienen apertura = 0).
+template <int Match, int Mismatch, int Gap> struct PuntuacionLineal {
+  static constexpr bool esAfin = false;
+  static constexpr int apertura = 0;
+  static constexpr int extension = Gap;
+  static constexpr int sustitucion(char a, char b) { return a == b ? Match : Mismatch; }
+};
+
+template <int Match, int Mismatch, int Apertura, int Extension> struct PuntuacionAfin {
+  static constexpr bool esAfin = true;
+  static constexpr int match = Match;
+  static constexpr int mismatch = Mismatch;
+  static constexpr int apertura = Apertura;
+  static constexpr int extension = Extension;
+  static constexpr int sustitucion(char a, char b) { return a == b ? Match : Mismatch; }
+};
+
+// Matriz de nucleotidos que castiga menos las transiciones (A<->G, C<->T) que las transversiones
+struct PuntuacionTransiciones {
+  static constexpr bool esAfin = false;
+  static constexpr int apertura = 0;
+  static constexpr int extension = GAP;
+  static constexpr int tabla[4][4] = {{1, -2, -1, -2}, {-2, 1, -2, -1}, {-1, -2, 1, -2}, {-2, -1, -2, 1}};
+  static constexpr int indice(char c) {
+    return c == 'A' ? 0 : c == 'C' ? 1 : c == 'G' ? 2 : (c == 'T' || c == 'U') ? 3 : -1;
+  }
+  static constexpr int sustitucion(char a, char b) {
+    int x = indice(a), y = indice(b);
+    return (x < 0 || y < 0) ? (a == b ? MATCH : MISMATCH) : tabla[x][y];
+  }
+};
+
+// Politicas pre-instanciadas, elegidas en tiempo de ejecucion con un unico despacho en la entrada
+using PuntuacionEstandar = PuntuacionLineal<MATCH, MISMATCH, GAP>;
+using PuntuacionBlastn = PuntuacionAfin<2, -3, -5, -2>;
+
+enum class EsquemaPuntuacion { Estandar, Transiciones, Blastn };
+
+// Alineamiento como transcripcion de edicion en formato CIGAR (rachas de longitud + operacion): '='
+// coincidencia, 'X' sustitucion, 'D' caracter de s1 frente a un gap, 'I' caracter de s2 frente a un gap.
+// Cada racha ocupa un uint32_t (longitud << 2 | codigo), asi un alineamiento guarda O(rachas) y no dos
+// cadenas con gaps; las cadenas se generan solo al imprimir.
+struct EstadisticasAlineamiento {
+  int columnas;
+  int coincidencias;
+  int sustituciones;
+  int gaps;          // cantidad de rachas de gap (aperturas)
+  int posicionesGap; // columnas con gap
+  double identidad() const { return columnas == 0 ? 0.0 : (double)coincidencias / columnas; }
+};
+
+class Cigar {
+public:
+  static constexpr const char *OPERACIONES = "=XDI";
+
+  // Agrega 'longitud' columnas de la operacion, extendiendo la ultima racha si coincide
+  void agregar(char operacion, uint32_t longitud = 1) {
+    if (longitud == 0)
+      return;
+    uint32_t codigo = codigoOperacion(operacion);
+    if (!rachas.empty() && (rachas.back() & 3) == codigo) {
+      rachas.back() += longitud << 2;
+    } else {
+      rachas.push_back(longitud << 2 | codigo);
+    }
+  }
+
+  // Columna con s1[i] frente a s2[j] ('=' o 'X' segun coincidan)
+  void agregarPar(char c1, char c2) { agregar(c1 == c2 ? '=' : 'X'); }
+
+  // El traceback agrega columnas de atras hacia adelante; al terminar se invierte el orden de las rachas
+  void invertir() { reverse(rachas.begin(), rachas.end()); }
+
+  void limpiar() { rachas.clear(); }
+  bool vacio() const { return rachas.empty(); }
+  size_t cantidadRachas() const { return rachas.size(); }
+  char operacion(size_t k) const { return OPERACIONES[rachas[k] & 3]; }
+  uint32_t longitud(size_t k) const { return rachas[k] >> 2; }
+  bool operator==(const Cigar &otro) const { return rachas == otro.rachas; }
+
+  // Texto compacto, p. ej. "3=1X2D4="
+  string texto() const {
+    string resultado;
+    for (size_t k = 0; k < rachas.size(); ++k) {
+      resultado += to_string(longitud(k));
+      resultado += operacion(k);
+    }
+    return resultado;
+  }
+
+  // Cadenas con gaps del alineamiento de s1[inicio1..] con s2[inicio2..] (el formato de siempre)
+  pair<string, string> expandir(const string &s1, const string &s2, int inicio1 = 0, int inicio2 = 0) const {
+    pair<string, string> alineamiento;
+    int i = inicio1, j = inicio2;
+    for (size_t k = 0; k < rachas.size(); ++k) {
+      uint32_t L = longitud(k);
+      char op = operacion(k);
+      if (op == 'I') {
+        alineamiento.first.append(L, '-');
+      } else {
+        alineamiento.first.append(s1, i, L);
+        i += L;
+      }
+      if (op == 'D') {
+        alineamiento.second.append(L, '-');
+      } else {
+        alineamiento.second.append(s2, j, L);
+        j += L;
+      }
+    }
+    return alineamiento;
+  }
+
+  EstadisticasAlineamiento estadisticas() const {
+    EstadisticasAlineamiento e = {0, 0, 0, 0, 0};
+    for (size_t k = 0; k < rachas.size(); ++k) {
+      int L = longitud(k);
+      e.columnas += L;
+      switch (operacion(k)) {
+      case '=':
+        e.coincidencias += L;
+        break;
+      case 'X':
+        e.sustituciones += L;
+        break;
+      default:
+        // Dos rachas de gap seguidas ('D' e 'I') son dos gaps distintos
+        e.gaps++;
+        e.posicionesGap += L;
+      }
+    }
+    return e;
+  }
+
+private:
+  static uint32_t codigoOperacion(char operacion) {
+    return operacion == '=' ? 0 : operacion == 'X' ? 1 : operacion == 'D' ? 2 : 3;
+  }
+
+  vector<uint32_t> rachas;
+};
+
+// Matriz de scores en un solo bloque contiguo por filas, para volcarla al disco con una sola escritura
+class MatrizScores {
+public:
+  void redimensionar(int filas, int columnas, int valor = 0) {
+    numFilas = filas;
+    numColumnas = columnas;
+    valores.assign((size_t)filas * columnas, valor);
+  }
+
+  int filas() const { return numFilas; }
+  int columnas() const { return numColumnas; }
+  bool vacia() const { return valores.empty(); }
+  int *fila(int i) { return &valores[(size_t)i * numColumnas]; }
+  const int *fila(int i) const { return &valores[(size_t)i * numColumnas]; }
+  int &operator()(int i, int j) { return valores[(size_t)i * numColumnas + j]; }
+  int operator()(int i, int j) const { return valores[(size_t)i * numColumnas + j]; }
+
+private:
+  int numFilas = 0;
+  int numColumnas = 0;
+  vector<int> valores;
+};
+
+// Subrectangulo [fila, fila + filas) x [columna, columna + columnas) de una matriz de scores
+struct Rectangulo {
+  int fila;
+  int columna;
+  int filas;
+  int columnas;
+};
+
+// Rectangulo que cubre el camino de un alineamiento que empieza en la celda (inicio1, inicio2),
+// ampliado en 'margen' celdas por lado y recortado a la matriz
+inline Rectangulo rectanguloCamino(const Cigar &cigar, int inicio1, int inicio2, int margen,
+                                   const MatrizScores &matriz) {
+  int fin1 = inicio1, fin2 = inicio2;
+  for (size_t k = 0; k < cigar.cantidadRachas(); ++k) {
+    if (cigar.operacion(k) != 'I')
+      fin1 += cigar.longitud(k);
+    if (cigar.operacion(k) != 'D')
+      fin2 += cigar.longitud(k);
+  }
+  int fila0 = max(0, inicio1 - margen), columna0 = max(0, inicio2 - margen);
+  int fila1 = min(matriz.filas() - 1, fin1 + margen), columna1 = min(matriz.columnas() - 1, fin2 + margen);
+  return {fila0, columna0, fila1 - fila0 + 1, columna1 - columna0 + 1};
+}
+
+// Vuelca el rectangulo en formato NumPy .npy (int32 little-endian, orden C; se carga con numpy.load).
+// Si abarca filas completas se escribe directo del buffer de la matriz en una sola llamada.
+static_assert(sizeof(int) == 4, "El volcado .npy asume int de 32 bits");
+inline bool exportarMatrizNpy(const string &nombreArchivo, const MatrizScores &matriz, const Rectangulo &r) {
+  ofstream archivo(nombreArchivo, ios::binary);
+  if (!archivo.is_open()) {
+    cerr << "Error al abrir el archivo " << nombreArchivo << endl;
+    return false;
+  }
+  // Cabecera: magic, version 1.0, longitud (uint16) y un diccionario de Python rellenado a multiplo de 64
+  string cabecera = "{'descr': '<i4', 'fortran_order': False, 'shape': (" + to_string(r.filas) + ", " +
+                    to_string(r.columnas) + "), }";
+  cabecera.append((64 - (10 + cabecera.size() + 1) % 64) % 64, ' ');
+  cabecera += '\n';
+  uint16_t longitudCabecera = cabecera.size();
+  archivo.write("\x93NUMPY\x01\x00", 8);
+  archivo.write((const char *)&longitudCabecera, sizeof(longitudCabecera));
+  archivo.write(cabecera.data(), cabecera.size());
+
+  if (r.columna == 0 && r.columnas == matriz.columnas()) {
+    archivo.write((const char *)matriz.fila(r.fila), (streamsize)r.filas * r.columnas * sizeof(int));
+  } else {
+    for (int i = r.fila; i < r.fila + r.filas; ++i)
+      archivo.write((const char *)(matriz.fila(i) + r.columna), (streamsize)r.columnas * sizeof(int));
+  }
+  return (bool)archivo;
+}
+
+// Que se escribe de la matriz de scores al guardar resultados. Por defecto nada: con secuencias largas
+// el texto ocupa cientos de MB y casi siempre solo interesan los alineamientos.
+struct OpcionesMatriz {
+  bool texto = false;    // la tabla de siempre (setw(4)) dentro del archivo de resultados
+  string archivoNpy;     // si no esta vacio, volcado binario .npy
+  int margenCamino = -1; // >= 0: solo el rectangulo del primer alineamiento mas este margen
+};
+
+// Matriz de traceback compacta: 3 bits por celda (diagonal, arriba, izquierda; varios a la vez si hay
+// empate), empaquetados de a 21 celdas por palabra de 64 bits (~10.7 veces menos que una matriz de int).
+// Solo guarda las celdas interiores (i, j >= 1); con bordesConGap la fila 0 apunta a la izquierda y la
+// columna 0 hacia arriba, como en el alineamiento global. Sin el (alineamiento local) los bordes no tienen
+// direcciones, igual que una celda de score 0: ahi empieza el alineamiento.
+class MatrizTraceback {
+public:
+  static const uint8_t DIAGONAL = 1;
+  static const uint8_t ARRIBA = 2;
+  static const uint8_t IZQUIERDA = 4;
+  static const int CELDAS_POR_PALABRA = 21;
+
+  MatrizTraceback(int filas = 0, int columnas = 0, bool bordesConGap = true)
+      : palabrasPorFila((columnas + CELDAS_POR_PALABRA - 1) / CELDAS_POR_PALABRA), bordesConGap(bordesConGap),
+        datos((size_t)filas * palabrasPorFila, 0) {}
+
+  void marcar(int i, int j, uint8_t direcciones) {
+    size_t c = j - 1;
+    datos[(size_t)(i - 1) * palabrasPorFila + c / CELDAS_POR_PALABRA] |= (uint64_t)direcciones
+                                                                         << (3 * (c % CELDAS_POR_PALABRA));
+  }
+
+  uint8_t direcciones(int i, int j) const {
+    if (i == 0 || j == 0) {
+      if (!bordesConGap || (i == 0 && j == 0))
+        return 0;
+      return i > 0 ? ARRIBA : IZQUIERDA;
+    }
+    size_t c = j - 1;
+    return (datos[(size_t)(i - 1) * palabrasPorFila + c / CELDAS_POR_PALABRA] >> (3 * (c % CELDAS_POR_PALABRA))) & 7;
+  }
+
+  size_t bytes() const { return datos.size() * sizeof(uint64_t); }
+
+private:
+  size_t palabrasPorFila;
+  bool bordesConGap;
+  vector<uint64_t> datos;
+};
+
+// Kernels afines (Gotoh) en memoria lineal. H es el mejor score de la celda, E el mejor que termina en
+// gap vertical (consume s1) y F el mejor que termina en gap horizontal (consume s2). Solo se guardan
+// filas (o antidiagonales) rotativas; el camino se recupera con la recursion de Myers-Miller.
+
+// Score de un gap de longitud L con la politica P
+template <class P> static inline int scoreGap(int L) { return L == 0 ? 0 : P::apertura + L * P::extension; }
+
+// Ultima fila de H y E al alinear globalmente a[0..n) con b[0..m). aperturaIni es lo que cuesta abrir el
+// gap vertical que sale de la esquina (0,0): P::apertura, o 0 si continua un gap del tramo anterior.
+template <class P>
+static void filaFinalAfinEscalar(const char *a, int n, const char *b, int m, int aperturaIni, int *H, int *E) {
+  H[0] = 0;
+  E[0] = MENOS_INFINITO;
+  for (int j = 1; j <= m; ++j) {
+    H[j] = scoreGap<P>(j);
+    E[j] = MENOS_INFINITO;
+  }
+  for (int i = 1; i <= n; ++i) {
+    int diagonal = H[0];
+    H[0] = E[0] = aperturaIni + i * P::extension;
+    int F = MENOS_INFINITO;
+    for (int j = 1; j <= m; ++j) {
+      int scoreDiagonal = diagonal + P::sustitucion(a[i - 1], b[j - 1]);
+      diagonal = H[j];
+      E[j] = max(E[j], H[j] + P::apertura) + P::extension;
+      F = max(F, H[j - 1] + P::apertura) + P::extension;
+      H[j] = max({scoreDiagonal, E[j], F});
+    }
+  }
+}
+
+// Misma recurrencia por antidiagonales con 8 celdas int32 por instruccion (AVX2). Los arreglos se indexan
+// por fila: en la antidiagonal d la celda i es (i, d - i), asi E lee i - 1 y F lee i de la anterior.
+template <class P>
+__attribute__((target("avx2"))) static void filaFinalAfinAVX2(const char *a, int n, const char *b, int m,
+                                                              int aperturaIni, int *H, int *E) {
+  string bRev(b, b + m);
+  reverse(bRev.begin(), bRev.end());
+  vector<int> H2(n + 1), H1(n + 1), H0(n + 1), E1(n + 1), E0(n + 1), F1(n + 1), F0(n + 1);
+  const __m256i vMatch = _mm256_set1_epi32(P::match);
+  const __m256i vMismatch = _mm256_set1_epi32(P::mismatch);
+  const __m256i vApertura = _mm256_set1_epi32(P::apertura);
+  const __m256i vExtension = _mm256_set1_epi32(P::extension);
+
+  H1[0] = 0; // antidiagonal 0: solo la esquina
+  for (int d = 1; d <= n + m; ++d) {
+    int ini = max(1, d - m);
+    int fin = min(n, d - 1);
+    // b[j-1] con j = d - i equivale a bRev[m - d + i]
+    const char *bDespl = bRev.data() + (m - d);
+    int i = ini;
+    for (; i + 7 <= fin; i += 8) {
+      __m256i ca = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(a + i - 1)));
+      __m256i cb = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(bDespl + i)));
+      __m256i s = _mm256_blendv_epi8(vMismatch, vMatch, _mm256_cmpeq_epi32(ca, cb));
+      __m256i hArriba = _mm256_loadu_si256((const __m256i *)&H1[i - 1]);
+      __m256i hIzquierda = _mm256_loadu_si256((const __m256i *)&H1[i]);
+      __m256i e = _mm256_add_epi32(
+          _mm256_max_epi32(_mm256_loadu_si256((const __m256i *)&E1[i - 1]), _mm256_add_epi32(hArriba, vApertura)),
+          vExtension);
+      __m256i f = _mm256_add_epi32(
+          _mm256_max_epi32(_mm256_loadu_si256((const __m256i *)&F1[i]), _mm256_add_epi32(hIzquierda, vApertura)),
+          vExtension);
+      __m256i h = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)&H2[i - 1]), s);
+      _mm256_storeu_si256((__m256i *)&E0[i], e);
+      _mm256_storeu_si256((__m256i *)&F0[i], f);
+      _mm256_storeu_si256((__m256i *)&H0[i], _mm256_max_epi32(h, _mm256_max_epi32(e, f)));
+    }
+    for (; i <= fin; ++i) {
+      E0[i] = max(E1[i - 1], H1[i - 1] + P::apertura) + P::extension;
+      F0[i] = max(F1[i], H1[i] + P::apertura) + P::extension;
+      H0[i] = max({H2[i - 1] + P::sustitucion(a[i - 1], bDespl[i]), E0[i], F0[i]});
+    }
+    // Bordes: fila 0 (gap horizontal) y columna 0 (gap vertical)
+    if (d <= m) {
+      H0[0] = scoreGap<P>(d);
+      E0[0] = F0[0] = MENOS_INFINITO;
+    }
+    if (d <= n) {
+      H0[d] = E0[d] = aperturaIni + d * P::extension;
+      F0[d] = MENOS_INFINITO;
+    }
+    // La fila n se completa de izquierda a derecha a partir de la antidiagonal n
+    if (d >= n) {
+      H[d - n] = H0[n];
+      E[d - n] = E0[n];
+    }
+    swap(H2, H1);
+    swap(H1, H0);
+    swap(E1, E0);
+    swap(F1, F0);
+  }
+}
+
+// Elige la variante del kernel: la vectorial (solo politicas afines de match/mismatch) compensa con
+// subproblemas grandes
+template <class P>
+static void filaFinalAfin(const char *a, int n, const char *b, int m, int aperturaIni, int *H, int *E) {
+  static const bool usarAVX2 = nivelSIMD() >= NivelSIMD::AVX2;
+  if constexpr (P::esAfin) {
+    if (usarAVX2 && n >= 64 && m >= 16) {
+      filaFinalAfinAVX2<P>(a, n, b, m, aperturaIni, H, E);
+      return;
+    }
+  }
+  filaFinalAfinEscalar<P>(a, n, b, m, aperturaIni, H, E);
+}
+
+// Myers-Miller: divide a por la mitad, combina la pasada directa con la inversa y recurre en cada mitad.
+// Si el mejor camino cruza la fila central dentro de un gap vertical, ese gap se emite aqui y los
+// tramos vecinos lo continuan sin volver a pagar la apertura. La memoria es O(m) mas la pila O(log n).
+template <class P>
+static void hirschbergAfin(const char *a, int n, const char *b, int m, int aperturaIni, int aperturaFin,
+                           Cigar &alineamiento) {
+  if (m == 0) {
+    alineamiento.agregar('D', n);
+    return;
+  }
+  if (n == 0) {
+    alineamiento.agregar('I', m);
+    return;
+  }
+  if (n == 1) {
+    // a[0] contra b[k], o bien a[0] como gap pegado al extremo que ya trae un gap abierto
+    int mejor = max(aperturaIni, aperturaFin) + P::extension + scoreGap<P>(m);
+    int mejorK = -1;
+    for (int k = 0; k < m; ++k) {
+      int score = scoreGap<P>(k) + P::sustitucion(a[0], b[k]) + scoreGap<P>(m - 1 - k);
+      if (score > mejor) {
+        mejor = score;
+        mejorK = k;
+      }
+    }
+    if (mejorK >= 0) {
+      alineamiento.agregar('I', mejorK);
+      alineamiento.agregarPar(a[0], b[mejorK]);
+      alineamiento.agregar('I', m - 1 - mejorK);
+    } else if (aperturaIni >= aperturaFin) {
+      alineamiento.agregar('D');
+      alineamiento.agregar('I', m);
+    } else {
+      alineamiento.agregar('I', m);
+      alineamiento.agregar('D');
+    }
+    return;
+  }
+
+  int mitad = n / 2;
+  int corte = 0;
+  bool porGap = false;
+  {
+    vector<int> HDirecta(m + 1), EDirecta(m + 1), HInversa(m + 1), EInversa(m + 1);
+    string aInv(a + mitad, a + n), bInv(b, b + m);
+    reverse(aInv.begin(), aInv.end());
+    reverse(bInv.begin(), bInv.end());
+    filaFinalAfin<P>(a, mitad, b, m, aperturaIni, HDirecta.data(), EDirecta.data());
+    filaFinalAfin<P>(aInv.data(), n - mitad, bInv.data(), m, aperturaFin, HInversa.data(), EInversa.data());
+
+    int mejor = MENOS_INFINITO;
+    for (int j = 0; j <= m; ++j) {
+      int scoreCelda = HDirecta[j] + HInversa[m - j];
+      int scoreGapCentral = EDirecta[j] + EInversa[m - j] - P::apertura;
+      if (scoreCelda > mejor) {
+        mejor = scoreCelda;
+        corte = j;
+        porGap = false;
+      }
+      if (scoreGapCentral > mejor) {
+        mejor = scoreGapCentral;
+        corte = j;
+        porGap = true;
+      }
+    }
+  }
+
+  if (!porGap) {
+    hirschbergAfin<P>(a, mitad, b, corte, aperturaIni, P::apertura, alineamiento);
+    hirschbergAfin<P>(a + mitad, n - mitad, b + corte, m - corte, P::apertura, aperturaFin, alineamiento);
+  } else {
+    hirschbergAfin<P>(a, mitad - 1, b, corte, aperturaIni, 0, alineamiento);
+    alineamiento.agregar('D', 2);
+    hirschbergAfin<P>(a + mitad + 1, n - mitad - 1, b + corte, m - corte, 0, aperturaFin, alineamiento);
+  }
+}
+
+// Score de un alineamiento ya construido: cada racha de 'D' o 'I' es un solo gap
+template <class P> int puntuarCigar(const Cigar &cigar, const string &s1, const string &s2, int inicio1 = 0,
+                                   int inicio2 = 0) {
+  int score = 0;
+  int i = inicio1, j = inicio2;
+  for (size_t k = 0; k < cigar.cantidadRachas(); ++k) {
+    int L = cigar.longitud(k);
+    char op = cigar.operacion(k);
+    if (op == 'D') {
+      score += scoreGap<P>(L);
+      i += L;
+    } else if (op == 'I') {
+      score += scoreGap<P>(L);
+      j += L;
+    } else {
+      for (int c = 0; c < L; ++c)
+        score += P::sustitucion(s1[i++], s2[j++]);
+    }
+  }
+  return score;
+}
+
+// Pool de hilos persistente: ejecutar(total, tarea) reparte los indices [0, total) entre los hilos
+// (incluido el que llama) y regresa cuando todos terminaron.
+class PoolHilos {
+public:
+  explicit PoolHilos(int numHilos) {
+    for (int h = 1; h < numHilos; ++h)
+      hilos.emplace_back([this] { trabajar(); });
+  }
+
+  ~PoolHilos() {
+    {
+      lock_guard<mutex> bloqueo(mtx);
+      detener = true;
+    }
+    cvTrabajo.notify_all();
+    for (auto &hilo : hilos)
+      hilo.join();
+  }
+
+  void ejecutar(int total, const function<void(int)> &tarea) {
+    {
+      lock_guard<mutex> bloqueo(mtx);
+      tareaActual = &tarea;
+      totalTareas = total;
+      siguiente = 0;
+      completadas = 0;
+      activos = hilos.size();
+      ++generacion;
+    }
+    cvTrabajo.notify_all();
+    procesar();
+    unique_lock<mutex> bloqueo(mtx);
+    cvFin.wait(bloqueo, [this] { return completadas == totalTareas && activos == 0; });
+  }
+
+private:
+  void procesar() {
+    int hechas = 0;
+    for (int idx = siguiente.fetch_add(1); idx < totalTareas; idx = siguiente.fetch_add(1)) {
+      (*tareaActual)(idx);
+      ++hechas;
+    }
+    lock_guard<mutex> bloqueo(mtx);
+    completadas += hechas;
+    cvFin.notify_all();
+  }
+
+  void trabajar() {
+    int generacionVista = 0;
+    while (true) {
+      {
+        unique_lock<mutex> bloqueo(mtx);
+        cvTrabajo.wait(bloqueo, [&] { return detener || generacion != generacionVista; });
+        if (detener)
+          return;
+        generacionVista = generacion;
+      }
+      procesar();
+      lock_guard<mutex> bloqueo(mtx);
+      --activos;
+      cvFin.notify_all();
+    }
+  }
+
+  vector<thread> hilos;
+  mutex mtx;
+  condition_variable cvTrabajo, cvFin;
+  const function<void(int)> *tareaActual = nullptr;
+  int totalTareas = 0;
+  atomic<int> siguiente{0};
+  int completadas = 0;
+  int activos = 0;
+  int generacion = 0;
+  bool detener = false;
+};
+
+// Recorre las antidiagonales de teselas; las teselas de una misma antidiagonal se llenan en paralelo
+inline void recorrerTeselas(PoolHilos &pool, int filasT, int colsT, const function<void(int, int)> &llenarTesela) {
+  for (int d = 0; d <= filasT + colsT - 2; ++d) {
+    int tiIni = max(0, d - (colsT - 1));
+    int tiFin = min(filasT - 1, d);
+    pool.ejecutar(tiFin - tiIni + 1, [&](int idx) { llenarTesela(tiIni + idx, d - tiIni - idx); });
+  }
+}
+
+// Secuencia aleatoria de nucleotidos para los benchmarks
+inline string generarSecuenciaAleatoria(int longitud, mt19937 &generador) {
+  string sec(longitud, 'A');
+  for (char &c : sec)
+    c = "ACGT"[generador() % 4];
+  return sec;
+}
+
+// Aplica sustituciones, inserciones y borrados con probabilidad total 'divergencia' por posicion
+inline string mutarSecuencia(const string &sec, double divergencia, mt19937 &generador) {
+  uniform_real_distribution<double> azar(0.0, 1.0);
+  string mutada;
+  for (char c : sec) {
+    double x = azar(generador);
+    if (x < divergencia / 3) {
+      mutada += "ACGT"[generador() % 4];
+    } else if (x < 2 * divergencia / 3) {
+      continue;
+    } else if (x < divergencia) {
+      mutada += c;
+      mutada += "ACGT"[generador() % 4];
+    } else {
+      mutada += c;
+    }
+  }
+  return mutada;
+}
+
+// Mide el tiempo en segundos de una funcion
+template <typename F> double medirSegundos(F &&funcion) {
+  auto inicio = chrono::steady_clock::now();
+  funcion();
+  return chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+}
+
+#endif
@@ -1,31 +1,695 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+#include "../lab01/doctest.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
+#include <functional>
+#include <immintrin.h>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
 #include <string>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
 #include <vector>
+
+#include "../comun/alineamiento.h"
 using namespace std;
 
+// Busqueda exacta de un patron con el algoritmo Two-Way (Crochemore-Perrin): tiempo O(n + m) y memoria
+// O(1) extra. El patron se parte en su factorizacion critica x = u v; se compara v de izquierda a derecha
+// y luego u de derecha a izquierda, y los saltos usan el periodo de x.
+class BuscadorTwoWay {
+public:
+  explicit BuscadorTwoWay(const string &patron) : patron(patron) {
+    int m = patron.length();
+    int periodo1, periodo2;
+    int sufijo1 = sufijoMaximo(false, periodo1);
+    int sufijo2 = sufijoMaximo(true, periodo2);
+    if (sufijo1 > sufijo2) {
+      critico = sufijo1;
+      periodo = periodo1;
+    } else {
+      critico = sufijo2;
+      periodo = periodo2;
+    }
+    // Si u es sufijo de v[0..periodo) el patron es periodico y se recuerda lo ya comparado entre saltos
+    periodico = critico + 1 <= m - periodo && patron.compare(0, critico + 1, patron, periodo, critico + 1) == 0;
+    if (!periodico)
+      periodo = max(critico + 1, m - critico - 1) + 1;
+  }
+
+  // Posiciones de inicio de las ocurrencias en el texto (a lo sumo maxOcurrencias)
+  vector<size_t> buscar(const string &texto, size_t maxOcurrencias = SIZE_MAX) const {
+    vector<size_t> posiciones;
+    long long n = texto.length(), m = patron.length();
+    if (m == 0) {
+      for (long long j = 0; j <= n && posiciones.size() < maxOcurrencias; ++j)
+        posiciones.push_back(j);
+      return posiciones;
+    }
+    const char *x = patron.data();
+    const char *y = texto.data();
+    long long j = 0;
+    long long memoria = -1; // prefijo ya verificado en la ventana anterior (solo patrones periodicos)
+    while (j <= n - m && posiciones.size() < maxOcurrencias) {
+      long long i = max<long long>(critico, memoria) + 1;
+      while (i < m && x[i] == y[i + j])
+        ++i;
+      if (i < m) {
+        j += i - critico;
+        memoria = -1;
+        continue;
+      }
+      long long limite = periodico ? memoria : -1;
+      i = critico;
+      while (i > limite && x[i] == y[i + j])
+        --i;
+      if (i <= limite)
+        posiciones.push_back(j);
+      j += periodo;
+      if (periodico)
+        memoria = m - periodo - 1;
+    }
+    return posiciones;
+  }
+
+private:
+  // Sufijo maximo del patron para el orden lexicografico (o su inverso); devuelve la posicion anterior
+  // al sufijo (-1 si es todo el patron) y su periodo
+  int sufijoMaximo(bool ordenInverso, int &p) const {
+    int m = patron.length();
+    int ms = -1, j = 0, k = 1;
+    p = 1;
+    while (j + k < m) {
+      char a = patron[j + k], b = patron[ms + k];
+      if (ordenInverso ? a > b : a < b) {
+        j += k;
+        k = 1;
+        p = j - ms;
+      } else if (a == b) {
+        if (k != p) {
+          ++k;
+        } else {
+          j += p;
+          k = 1;
+        }
+      } else {
+        ms = j;
+        j = ms + 1;
+        k = p = 1;
+      }
+    }
+    return ms;
+  }
+
+  string patron;
+  int critico;
+  int periodo;
+  bool periodico;
+};
+
+// Automata de Aho-Corasick para buscar muchos patrones (primers, adaptadores) en una sola pasada por el
+// texto: O(n + ocurrencias) por texto sin importar cuantos patrones haya. Las transiciones se guardan
+// completas (DFA) sobre el alfabeto de los patrones, asi cada caracter cuesta una sola lectura de tabla.
+struct Ocurrencia {
+  int patron;      // indice del patron, en el orden en que se agrego
+  size_t posicion; // posicion de inicio en el texto
+};
+
+class AutomataAhoCorasick {
+public:
+  explicit AutomataAhoCorasick(const vector<string> &patrones) {
+    // Alfabeto compacto: solo los caracteres que aparecen en algun patron; el resto vuelve a la raiz
+    codigo.fill(-1);
+    for (const auto &patron : patrones)
+      for (unsigned char c : patron)
+        if (codigo[c] < 0)
+          codigo[c] = tamAlfabeto++;
+
+    nuevoEstado();
+    for (size_t id = 0; id < patrones.size(); ++id) {
+      int estado = 0;
+      for (unsigned char c : patrones[id]) {
+        size_t indice = (size_t)estado * tamAlfabeto + codigo[c];
+        if (transiciones[indice] == 0) {
+          int nuevo = nuevoEstado();
+          transiciones[indice] = nuevo;
+        }
+        estado = transiciones[indice];
+      }
+      longitudes.push_back(patrones[id].length());
+      patronesEstado[estado].push_back(id);
+    }
+
+    // Recorrido por niveles: enlace de fallo, transiciones faltantes y enlace al siguiente estado con salida
+    vector<int> cola;
+    for (int c = 0; c < tamAlfabeto; ++c)
+      if (transiciones[c] != 0)
+        cola.push_back(transiciones[c]);
+    for (size_t k = 0; k < cola.size(); ++k) {
+      int estado = cola[k];
+      int fallo = enlaceFallo[estado];
+      enlaceSalida[estado] = patronesEstado[fallo].empty() ? enlaceSalida[fallo] : fallo;
+      for (int c = 0; c < tamAlfabeto; ++c) {
+        int &destino = transiciones[(size_t)estado * tamAlfabeto + c];
+        int destinoFallo = transiciones[(size_t)fallo * tamAlfabeto + c];
+        if (destino != 0) {
+          enlaceFallo[destino] = destinoFallo;
+          cola.push_back(destino);
+        } else {
+          destino = destinoFallo;
+        }
+      }
+    }
+  }
+
+  int cantidadEstados() const { return enlaceFallo.size(); }
+
+  // Llama a alEncontrar(patron, posicion) por cada ocurrencia, sin guardar resultados intermedios
+  template <typename F> void recorrer(const string &texto, F &&alEncontrar) const {
+    // Los patrones vacios coinciden en todas las posiciones
+    for (int id : patronesEstado[0])
+      for (size_t pos = 0; pos <= texto.length(); ++pos)
+        alEncontrar(id, pos);
+    int estado = 0;
+    for (size_t pos = 0; pos < texto.length(); ++pos) {
+      int c = codigo[(unsigned char)texto[pos]];
+      estado = c < 0 ? 0 : transiciones[(size_t)estado * tamAlfabeto + c];
+      for (int salida = patronesEstado[estado].empty() ? enlaceSalida[estado] : estado; salida > 0;
+           salida = enlaceSalida[salida]) {
+        for (int id : patronesEstado[salida])
+          alEncontrar(id, pos + 1 - longitudes[id]);
+      }
+    }
+  }
+
+  vector<Ocurrencia> buscar(const string &texto) const {
+    vector<Ocurrencia> ocurrencias;
+    recorrer(texto, [&](int id, size_t pos) { ocurrencias.push_back({id, pos}); });
+    return ocurrencias;
+  }
+
+private:
+  int nuevoEstado() {
+    transiciones.resize(transiciones.size() + tamAlfabeto, 0);
+    enlaceFallo.push_back(0);
+    enlaceSalida.push_back(0);
+    patronesEstado.emplace_back();
+    return enlaceFallo.size() - 1;
+  }
+
+  array<int, 256> codigo;
+  int tamAlfabeto = 0;
+  vector<int> transiciones; // estado * tamAlfabeto + codigo -> estado
+  vector<int> enlaceFallo;
+  vector<int> enlaceSalida; // siguiente estado (por enlaces de fallo) que termina algun patron; 0 si no hay
+  vector<vector<int>> patronesEstado;
+  vector<size_t> longitudes;
+};
+
 // Función para verificar si una cadena es subcadena de otra
 bool esSubstring(const string &cadena, const string &subcadena) {
-  if (subcadena.length() > cadena.length()) {
-    return false;
+  return !BuscadorTwoWay(subcadena).buscar(cadena, 1).empty();
+}
+
+// Arreglo de sufijos con SA-IS (Nong, Zhang y Chan): tiempo O(n). s[0..n) usa simbolos en [0, K) y
+// termina en un centinela 0 unico. Los sufijos LMS se ordenan por induccion; si sus nombres no son
+// unicos se recurre sobre la cadena reducida, que vive dentro del propio SA.
+template <typename T> static void construirSAIS(const T *s, int *SA, int n, int K) {
+  if (n == 1) {
+    SA[0] = 0;
+    return;
   }
-  for (size_t i = 0; i <= cadena.length() - subcadena.length(); ++i) {
-    bool coincide = true;
-    for (size_t j = 0; j < subcadena.length(); ++j) {
-      if (cadena[i + j] != subcadena[j]) {
-        coincide = false;
+  vector<bool> tipoS(n);
+  tipoS[n - 1] = true;
+  for (int i = n - 2; i >= 0; --i)
+    tipoS[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && tipoS[i + 1]);
+  auto esLMS = [&](int i) { return i > 0 && tipoS[i] && !tipoS[i - 1]; };
+
+  vector<int> tamCubeta(K, 0), cubeta(K);
+  for (int i = 0; i < n; ++i)
+    tamCubeta[s[i]]++;
+  auto iniciosCubetas = [&] {
+    for (int c = 0, suma = 0; c < K; ++c) {
+      cubeta[c] = suma;
+      suma += tamCubeta[c];
+    }
+  };
+  auto finesCubetas = [&] {
+    for (int c = 0, suma = 0; c < K; ++c) {
+      suma += tamCubeta[c];
+      cubeta[c] = suma;
+    }
+  };
+  auto inducir = [&] {
+    iniciosCubetas();
+    for (int i = 0; i < n; ++i)
+      if (SA[i] > 0 && !tipoS[SA[i] - 1])
+        SA[cubeta[s[SA[i] - 1]]++] = SA[i] - 1;
+    finesCubetas();
+    for (int i = n - 1; i >= 0; --i)
+      if (SA[i] > 0 && tipoS[SA[i] - 1])
+        SA[--cubeta[s[SA[i] - 1]]] = SA[i] - 1;
+  };
+
+  // 1. Ordenar las subcadenas LMS
+  fill(SA, SA + n, -1);
+  finesCubetas();
+  for (int i = 1; i < n; ++i)
+    if (esLMS(i))
+      SA[--cubeta[s[i]]] = i;
+  inducir();
+
+  // 2. Nombrar las subcadenas LMS; nombres iguales si son identicas (simbolos y tipos)
+  int n1 = 0;
+  for (int i = 0; i < n; ++i)
+    if (esLMS(SA[i]))
+      SA[n1++] = SA[i];
+  fill(SA + n1, SA + n, -1);
+  int nombres = 0, anterior = -1;
+  for (int i = 0; i < n1; ++i) {
+    int pos = SA[i];
+    bool distinta = false;
+    for (int d = 0; d < n; ++d) {
+      if (anterior == -1 || s[pos + d] != s[anterior + d] || tipoS[pos + d] != tipoS[anterior + d]) {
+        distinta = true;
         break;
       }
+      if (d > 0 && (esLMS(pos + d) || esLMS(anterior + d)))
+        break;
     }
-    if (coincide) {
-      return true;
+    if (distinta) {
+      nombres++;
+      anterior = pos;
     }
+    SA[n1 + pos / 2] = nombres - 1;
+  }
+  for (int i = n - 1, j = n - 1; i >= n1; --i)
+    if (SA[i] >= 0)
+      SA[j--] = SA[i];
+
+  // 3. Orden de los sufijos LMS: por recursion si hay nombres repetidos
+  int *s1 = SA + n - n1;
+  if (nombres < n1) {
+    construirSAIS<int>(s1, SA, n1, nombres);
+  } else {
+    for (int i = 0; i < n1; ++i)
+      SA[s1[i]] = i;
   }
-  return false;
+
+  // 4. Inducir el orden de todos los sufijos a partir de los LMS ordenados
+  for (int i = 1, j = 0; i < n; ++i)
+    if (esLMS(i))
+      s1[j++] = i;
+  for (int i = 0; i < n1; ++i)
+    SA[i] = s1[SA[i]];
+  fill(SA + n1, SA + n, -1);
+  finesCubetas();
+  for (int i = n1 - 1; i >= 0; --i) {
+    int j = SA[i];
+    SA[i] = -1;
+    SA[--cubeta[s[j]]] = j;
+  }
+  inducir();
 }
 
+// Indice FM de una referencia fija: BWT con rangos por bloques de 64 posiciones (un contador de 32 bits y
+// una mascara de 64 bits por simbolo y bloque), mas un SA muestreado cada 'paso' posiciones del texto para
+// localizar. contar() cuesta O(m) sin importar el tamano de la referencia.
+//
+// En memoria y en disco el indice es un unico bloque: cabecera seguida de los arreglos, todos alineados a
+// 8 bytes. guardar() lo escribe tal cual y abrir() lo proyecta con mmap sin copiarlo ni reconstruirlo.
+class IndiceFM {
+public:
+  IndiceFM() = default;
+  IndiceFM(const IndiceFM &) = delete;
+  IndiceFM &operator=(const IndiceFM &) = delete;
+  ~IndiceFM() { cerrarProyeccion(); }
+
+  // Devuelve false (y deja el indice vacio) si la referencia usa mas de MAX_SIGMA caracteres distintos:
+  // el texto guarda codigo + 1 en un byte y SIN_CODIGO debe quedar libre
+  bool construir(const string &referencia, int pasoMuestreo = 32) {
+    cerrarProyeccion();
+    almacenamiento.clear();
+    int n = referencia.length() + 1;
+
+    // Alfabeto compacto: codigos 1..sigma en orden de caracter; 0 es el centinela
+    CabeceraFM cabecera = {};
+    memcpy(cabecera.magia, MAGIA, sizeof(cabecera.magia));
+    vector<uint64_t> frecuencia(256, 0);
+    for (unsigned char c : referencia)
+      frecuencia[c]++;
+    memset(cabecera.codigo, SIN_CODIGO, sizeof(cabecera.codigo));
+    int sigma = 0;
+    for (int c = 0; c < 256; ++c)
+      if (frecuencia[c] > 0)
+        cabecera.codigo[c] = sigma++;
+    if (sigma > MAX_SIGMA) {
+      cerr << "Error: la referencia usa " << sigma << " caracteres distintos; el indice FM admite hasta "
+           << MAX_SIGMA << endl;
+      return false;
+    }
+    vector<uint8_t> texto(n);
+    for (int i = 0; i + 1 < n; ++i)
+      texto[i] = cabecera.codigo[(unsigned char)referencia[i]] + 1;
+    texto[n - 1] = 0;
+
+    vector<int> SA(n);
+    construirSAIS<uint8_t>(texto.data(), SA.data(), n, sigma + 1);
+
+    cabecera.longitud = n;
+    cabecera.sigma = sigma;
+    cabecera.paso = pasoMuestreo;
+    cabecera.bloques = n / 64 + 1;
+    cabecera.muestras = (n - 1) / pasoMuestreo + 1;
+    for (int c = 0, acumulado = 1; c < 256; ++c) {
+      if (cabecera.codigo[c] != SIN_CODIGO) {
+        cabecera.C[cabecera.codigo[c]] = acumulado;
+        acumulado += frecuencia[c];
+      }
+    }
+    almacenamiento.assign(tamanoTotal(cabecera) / sizeof(uint64_t), 0);
+    memcpy(almacenamiento.data(), &cabecera, sizeof(cabecera));
+    enlazar((const uint8_t *)almacenamiento.data());
+    uint32_t *cuentasEscritura = (uint32_t *)cuentas;
+    uint64_t *bitsEscritura = (uint64_t *)bits;
+    uint64_t *marcasEscritura = (uint64_t *)marcas;
+    uint32_t *rangoMarcasEscritura = (uint32_t *)rangoMarcas;
+    uint32_t *muestrasEscritura = (uint32_t *)muestras;
+
+    // Recorrer el SA en orden: simbolo de la BWT, contadores por bloque y muestras del SA
+    vector<uint32_t> acumulado(sigma, 0);
+    uint32_t marcadas = 0;
+    for (int i = 0; i <= n; ++i) {
+      size_t bloque = i >> 6;
+      if ((i & 63) == 0) {
+        copy(acumulado.begin(), acumulado.end(), cuentasEscritura + bloque * sigma);
+        rangoMarcasEscritura[bloque] = marcadas;
+      }
+      if (i == n)
+        break;
+      if (SA[i] == 0) {
+        ((CabeceraFM *)almacenamiento.data())->posicionCentinela = i;
+      } else {
+        int c = texto[SA[i] - 1] - 1;
+        bitsEscritura[bloque * sigma + c] |= 1ULL << (i & 63);
+        acumulado[c]++;
+      }
+      if (SA[i] % pasoMuestreo == 0) {
+        marcasEscritura[bloque] |= 1ULL << (i & 63);
+        muestrasEscritura[marcadas++] = SA[i];
+      }
+    }
+    return true;
+  }
+
+  // Escribe el indice en una sola llamada; el archivo se puede abrir con mmap
+  bool guardar(const string &nombreArchivo) const {
+    if (!cabecera)
+      return false;
+    ofstream archivo(nombreArchivo, ios::binary);
+    if (!archivo.is_open()) {
+      cerr << "Error al abrir el archivo " << nombreArchivo << endl;
+      return false;
+    }
+    archivo.write((const char *)base, tamanoTotal(*cabecera));
+    return (bool)archivo;
+  }
+
+  // Proyecta un indice guardado; las consultas leen directamente de las paginas del archivo
+  bool abrir(const string &nombreArchivo) {
+    cerrarProyeccion();
+    almacenamiento.clear();
+    int fd = open(nombreArchivo.c_str(), O_RDONLY);
+    if (fd < 0) {
+      cerr << "Error al abrir el archivo " << nombreArchivo << endl;
+      return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      close(fd);
+      cerr << "Error al leer el tamano de " << nombreArchivo << endl;
+      return false;
+    }
+    void *mapa = info.st_size >= (off_t)sizeof(CabeceraFM)
+                     ? mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)
+                     : MAP_FAILED;
+    close(fd);
+    if (mapa == MAP_FAILED || memcmp(mapa, MAGIA, 8) != 0 ||
+        tamanoTotal(*(const CabeceraFM *)mapa) != (size_t)info.st_size) {
+      if (mapa != MAP_FAILED)
+        munmap(mapa, info.st_size);
+      cerr << "Error: " << nombreArchivo << " no es un indice FM valido" << endl;
+      return false;
+    }
+    proyeccion = mapa;
+    tamProyeccion = info.st_size;
+    enlazar((const uint8_t *)mapa);
+    return true;
+  }
+
+  // Cantidad de ocurrencias del patron (busqueda hacia atras, O(m))
+  size_t contar(const string &patron) const {
+    pair<size_t, size_t> rango = rangoSA(patron);
+    return rango.second - rango.first;
+  }
+
+  bool contiene(const string &patron) const { return contar(patron) > 0; }
+
+  // Posiciones de inicio de todas las ocurrencias, ordenadas; cada una cuesta a lo sumo 'paso' pasos LF
+  vector<size_t> localizar(const string &patron) const {
+    pair<size_t, size_t> rango = rangoSA(patron);
+    vector<size_t> posiciones;
+    for (size_t i = rango.first; i < rango.second; ++i) {
+      size_t fila = i, pasos = 0;
+      while (!((marcas[fila >> 6] >> (fila & 63)) & 1)) {
+        fila = LF(fila);
+        pasos++;
+      }
+      posiciones.push_back(muestras[rangoMarcado(fila)] + pasos);
+    }
+    sort(posiciones.begin(), posiciones.end());
+    return posiciones;
+  }
+
+  size_t longitudReferencia() const { return cabecera ? cabecera->longitud - 1 : 0; }
+  size_t bytes() const { return cabecera ? tamanoTotal(*cabecera) : 0; }
+
+private:
+  static constexpr const char *MAGIA = "FMINDEX1";
+  static const uint8_t SIN_CODIGO = 255;
+  static const int MAX_SIGMA = 254; // codigos 0..253: codigo + 1 cabe en el texto sin tocar SIN_CODIGO
+
+  struct CabeceraFM {
+    char magia[8];
+    uint64_t longitud; // longitud de la BWT (referencia + centinela)
+    uint64_t posicionCentinela;
+    uint32_t sigma;
+    uint32_t paso;
+    uint64_t bloques;
+    uint64_t muestras;
+    uint64_t C[256];      // C[c]: fila del SA donde empiezan los sufijos que comienzan con el codigo c
+    uint8_t codigo[256]; // caracter -> codigo compacto (SIN_CODIGO si no aparece)
+  };
+
+  static size_t alinear8(size_t bytes) { return (bytes + 7) & ~(size_t)7; }
+
+  static size_t tamanoTotal(const CabeceraFM &c) {
+    return sizeof(CabeceraFM) + alinear8(c.bloques * c.sigma * sizeof(uint32_t)) +
+           c.bloques * c.sigma * sizeof(uint64_t) + c.bloques * sizeof(uint64_t) +
+           alinear8(c.bloques * sizeof(uint32_t)) + alinear8(c.muestras * sizeof(uint32_t));
+  }
+
+  // Apunta cada arreglo a su seccion dentro del bloque (propio o proyectado)
+  void enlazar(const uint8_t *inicio) {
+    base = inicio;
+    cabecera = (const CabeceraFM *)inicio;
+    const uint8_t *p = inicio + sizeof(CabeceraFM);
+    cuentas = (const uint32_t *)p;
+    p += alinear8(cabecera->bloques * cabecera->sigma * sizeof(uint32_t));
+    bits = (const uint64_t *)p;
+    p += cabecera->bloques * cabecera->sigma * sizeof(uint64_t);
+    marcas = (const uint64_t *)p;
+    p += cabecera->bloques * sizeof(uint64_t);
+    rangoMarcas = (const uint32_t *)p;
+    p += alinear8(cabecera->bloques * sizeof(uint32_t));
+    muestras = (const uint32_t *)p;
+  }
+
+  void cerrarProyeccion() {
+    if (proyeccion)
+      munmap(proyeccion, tamProyeccion);
+    proyeccion = nullptr;
+    cabecera = nullptr;
+  }
+
+  // Ocurrencias del codigo c en BWT[0..i)
+  size_t rango(int c, size_t i) const {
+    size_t k = (i >> 6) * cabecera->sigma + c;
+    return cuentas[k] + __builtin_popcountll(bits[k] & ((1ULL << (i & 63)) - 1));
+  }
+
+  size_t rangoMarcado(size_t i) const {
+    return rangoMarcas[i >> 6] + __builtin_popcountll(marcas[i >> 6] & ((1ULL << (i & 63)) - 1));
+  }
+
+  // Fila del SA del sufijo que empieza una posicion antes (LF-mapping)
+  size_t LF(size_t i) const {
+    size_t k = (i >> 6) * cabecera->sigma;
+    for (uint32_t c = 0; c < cabecera->sigma; ++c)
+      if ((bits[k + c] >> (i & 63)) & 1)
+        return cabecera->C[c] + rango(c, i);
+    return 0; // centinela: el sufijo completo es la fila 0
+  }
+
+  // Intervalo [inicio, fin) del SA cuyos sufijos empiezan con el patron
+  pair<size_t, size_t> rangoSA(const string &patron) const {
+    if (!cabecera)
+      return {0, 0};
+    size_t inicio = 0, fin = cabecera->longitud;
+    for (size_t k = patron.length(); k-- > 0 && inicio < fin;) {
+      uint8_t c = cabecera->codigo[(unsigned char)patron[k]];
+      if (c == SIN_CODIGO)
+        return {0, 0};
+      inicio = cabecera->C[c] + rango(c, inicio);
+      fin = cabecera->C[c] + rango(c, fin);
+    }
+    return {inicio, max(inicio, fin)};
+  }
+
+  vector<uint64_t> almacenamiento; // bloque propio cuando el indice se construye en memoria
+  void *proyeccion = nullptr;      // bloque proyectado cuando se abre de disco
+  size_t tamProyeccion = 0;
+  const uint8_t *base = nullptr;
+  const CabeceraFM *cabecera = nullptr;
+  const uint32_t *cuentas = nullptr;
+  const uint64_t *bits = nullptr;
+  const uint64_t *marcas = nullptr;
+  const uint32_t *rangoMarcas = nullptr;
+  const uint32_t *muestras = nullptr;
+};
+
+// Busqueda aproximada con a lo sumo k diferencias (sustituciones o indels) con el algoritmo de bits
+// paralelos de Myers: la columna de la matriz de edicion (patron completo contra cualquier subcadena del
+// texto) se guarda como vectores de diferencias verticales +1/-1, de a 64 filas por palabra. Cada
+// caracter del texto cuesta O(m / 64) operaciones de palabra; los patrones de mas de 64 bases usan
+// varios bloques encadenados por el acarreo horizontal (Hyyro).
+struct CoincidenciaAproximada {
+  size_t fin;     // posicion del ultimo caracter de la ocurrencia en el texto
+  int distancia;  // distancia de edicion del patron a la mejor subcadena que termina ahi
+};
+
+struct CoincidenciaLectura {
+  int lectura;
+  size_t fin;
+  int distancia;
+};
+
+class BuscadorAproximado {
+public:
+  explicit BuscadorAproximado(const string &patron)
+      : m(patron.length()), bloques((patron.length() + 63) / 64), coincidencias(256 * bloques, 0) {
+    for (int i = 0; i < m; ++i)
+      coincidencias[(unsigned char)patron[i] * bloques + i / 64] |= 1ULL << (i % 64);
+    bitFinal = m == 0 ? 0 : 1ULL << ((m - 1) % 64);
+  }
+
+  // Llama a alEncontrar(fin, distancia) en cada posicion del texto donde termina una ocurrencia con
+  // distancia <= maxDiferencias
+  template <typename F> void recorrer(const string &texto, int maxDiferencias, F &&alEncontrar) const {
+    if (m == 0) {
+      for (size_t j = 0; j < texto.length(); ++j)
+        alEncontrar(j, 0);
+      return;
+    }
+    if (bloques == 1) {
+      recorrerUnBloque(texto, maxDiferencias, alEncontrar);
+      return;
+    }
+    vector<uint64_t> Pv(bloques, ~0ULL), Mv(bloques, 0);
+    int score = m;
+    for (size_t j = 0; j < texto.length(); ++j) {
+      const uint64_t *Eq = &coincidencias[(unsigned char)texto[j] * bloques];
+      int acarreo = 0; // diferencia horizontal que entra al bloque por su fila superior
+      for (int b = 0; b < bloques; ++b) {
+        uint64_t ph, mh;
+        avanzarBloque(Pv[b], Mv[b], Eq[b], acarreo, ph, mh);
+        uint64_t alto = b == bloques - 1 ? bitFinal : 1ULL << 63;
+        acarreo = ((ph & alto) != 0) - ((mh & alto) != 0);
+      }
+      score += acarreo;
+      if (score <= maxDiferencias)
+        alEncontrar(j, score);
+    }
+  }
+
+  vector<CoincidenciaAproximada> buscar(const string &texto, int maxDiferencias) const {
+    vector<CoincidenciaAproximada> resultado;
+    recorrer(texto, maxDiferencias, [&](size_t fin, int distancia) { resultado.push_back({fin, distancia}); });
+    return resultado;
+  }
+
+  // Variante por lotes: el mismo patron (preprocesado una vez) contra muchas lecturas
+  vector<CoincidenciaLectura> buscarEnLecturas(const vector<string> &lecturas, int maxDiferencias) const {
+    vector<CoincidenciaLectura> resultado;
+    for (size_t r = 0; r < lecturas.size(); ++r) {
+      recorrer(lecturas[r], maxDiferencias,
+               [&](size_t fin, int distancia) { resultado.push_back({(int)r, fin, distancia}); });
+    }
+    return resultado;
+  }
+
+private:
+  // Avanza un bloque de 64 filas una columna. 'acarreo' es la diferencia horizontal de la fila superior
+  // del bloque (0 en el primero: la fila 0 vale 0 en todo el texto); ph/mh salen sin desplazar.
+  static inline void avanzarBloque(uint64_t &Pv, uint64_t &Mv, uint64_t Eq, int acarreo, uint64_t &ph,
+                                   uint64_t &mh) {
+    uint64_t Xv = Eq | Mv;
+    if (acarreo < 0)
+      Eq |= 1;
+    uint64_t Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+    ph = Mv | ~(Xh | Pv);
+    mh = Pv & Xh;
+    uint64_t phDesplazado = ph << 1 | (acarreo > 0);
+    uint64_t mhDesplazado = mh << 1 | (acarreo < 0);
+    Pv = mhDesplazado | ~(Xv | phDesplazado);
+    Mv = phDesplazado & Xv;
+  }
+
+  // Caso de una sola palabra (patrones de hasta 64 bases), sin lazo de bloques
+  template <typename F> void recorrerUnBloque(const string &texto, int maxDiferencias, F &&alEncontrar) const {
+    uint64_t Pv = ~0ULL, Mv = 0;
+    int score = m;
+    for (size_t j = 0; j < texto.length(); ++j) {
+      uint64_t ph, mh;
+      avanzarBloque(Pv, Mv, coincidencias[(unsigned char)texto[j]], 0, ph, mh);
+      score += ((ph & bitFinal) != 0) - ((mh & bitFinal) != 0);
+      if (score <= maxDiferencias)
+        alEncontrar(j, score);
+    }
+  }
+
+  int m;
+  int bloques;
+  vector<uint64_t> coincidencias; // [caracter][bloque]: bit i si patron[64 * bloque + i] == caracter
+  uint64_t bitFinal;              // bit de la ultima fila del patron dentro del ultimo bloque
+};
+
 // Función para calcular el score entre dos cadenas
 int calcularScoreSimple(const string &cadena1, const string &cadena2) {
   int score = 0;
@@ -42,117 +706,1273 @@ int calcularScoreSimple(const string &cadena1, const string &cadena2) {
   return score;
 }
 
-// Parámetros para el alineamiento global
-const int MATCH = 1;
-const int MISMATCH = -1;
-const int GAP = -2;
+// Score sin gaps sobre secuencias empaquetadas a 2 bits por base (A=0, C=1, G=2, T=3), 32 bases por
+// palabra de 64 bits con la base k en los bits 2*(k % 32). Dos bases difieren si alguno de sus dos bits
+// difiere: las sustituciones de 32 posiciones salen de un XOR, un OR con el desplazado y un popcount.
+// Como hay score +1 por coincidencia y -2 por sustitucion, score = L - 3 * sustituciones - 2 * |n1 - n2|
+// con L = min(n1, n2), igual que calcularScoreSimple.
+static const uint64_t BITS_PARES = 0x5555555555555555ULL;
+
+// Empaqueta s en 'palabras' (agregando al final); false si tiene algo distinto de A, C, G o T
+static bool empaquetarBases(const string &s, vector<uint64_t> &palabras) {
+  size_t inicio = palabras.size();
+  palabras.resize(inicio + (s.length() + 31) / 32, 0);
+  for (size_t k = 0; k < s.length(); ++k) {
+    uint64_t codigo;
+    switch (s[k]) {
+    case 'A': codigo = 0; break;
+    case 'C': codigo = 1; break;
+    case 'G': codigo = 2; break;
+    case 'T': codigo = 3; break;
+    default:
+      palabras.resize(inicio);
+      return false;
+    }
+    palabras[inicio + k / 32] |= codigo << (2 * (k % 32));
+  }
+  return true;
+}
+
+static string desempaquetarBases(const uint64_t *palabras, size_t longitud) {
+  string s(longitud, 'A');
+  for (size_t k = 0; k < longitud; ++k)
+    s[k] = "ACGT"[(palabras[k / 32] >> (2 * (k % 32))) & 3];
+  return s;
+}
+
+// Un bit (el par) por cada base distinta entre dos palabras
+static inline uint64_t basesDistintas(uint64_t x, uint64_t y) {
+  uint64_t d = x ^ y;
+  return (d | d >> 1) & BITS_PARES;
+}
+
+// Sustituciones entre las primeras 'bases' bases de x e y (solo lee las palabras que las contienen,
+// ninguna de relleno). Variantes: popcount portable, instruccion
+// POPCNT, AVX2 (popcount por tabla de nibbles, 4 palabras por instruccion) y AVX-512 VPOPCNTQ (8 palabras)
+static size_t sustitucionesEscalar(const uint64_t *x, const uint64_t *y, size_t bases) {
+  size_t completas = bases / 32, total = 0;
+  for (size_t k = 0; k < completas; ++k)
+    total += __builtin_popcountll(basesDistintas(x[k], y[k]));
+  if (bases % 32)
+    total += __builtin_popcountll(basesDistintas(x[completas], y[completas]) & ((1ULL << 2 * (bases % 32)) - 1));
+  return total;
+}
+
+__attribute__((target("popcnt"))) static size_t sustitucionesPopcnt(const uint64_t *x, const uint64_t *y,
+                                                                   size_t bases) {
+  size_t completas = bases / 32, total = 0;
+  for (size_t k = 0; k < completas; ++k)
+    total += _mm_popcnt_u64(basesDistintas(x[k], y[k]));
+  if (bases % 32)
+    total += _mm_popcnt_u64(basesDistintas(x[completas], y[completas]) & ((1ULL << 2 * (bases % 32)) - 1));
+  return total;
+}
+
+__attribute__((target("avx2,popcnt"))) static size_t sustitucionesAVX2(const uint64_t *x, const uint64_t *y,
+                                                                      size_t bases) {
+  const __m256i pares = _mm256_set1_epi64x(BITS_PARES);
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  const __m256i tabla = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1,
+                                         2, 2, 3, 2, 3, 3, 4);
+  size_t completas = bases / 32, k = 0;
+  __m256i acumulado = _mm256_setzero_si256();
+  for (; k + 4 <= completas; k += 4) {
+    __m256i d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(x + k)),
+                                 _mm256_loadu_si256((const __m256i *)(y + k)));
+    d = _mm256_and_si256(_mm256_or_si256(d, _mm256_srli_epi64(d, 1)), pares);
+    __m256i cuenta = _mm256_add_epi8(_mm256_shuffle_epi8(tabla, _mm256_and_si256(d, nibble)),
+                                     _mm256_shuffle_epi8(tabla, _mm256_and_si256(_mm256_srli_epi64(d, 4), nibble)));
+    acumulado = _mm256_add_epi64(acumulado, _mm256_sad_epu8(cuenta, _mm256_setzero_si256()));
+  }
+  size_t total = _mm256_extract_epi64(acumulado, 0) + _mm256_extract_epi64(acumulado, 1) +
+                 _mm256_extract_epi64(acumulado, 2) + _mm256_extract_epi64(acumulado, 3);
+  for (; k < completas; ++k)
+    total += _mm_popcnt_u64(basesDistintas(x[k], y[k]));
+  if (bases % 32)
+    total += _mm_popcnt_u64(basesDistintas(x[completas], y[completas]) & ((1ULL << 2 * (bases % 32)) - 1));
+  return total;
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq,popcnt"))) static size_t
+sustitucionesAVX512(const uint64_t *x, const uint64_t *y, size_t bases) {
+  const __m512i pares = _mm512_set1_epi64(BITS_PARES);
+  size_t completas = bases / 32;
+  __m512i acumulado = _mm512_setzero_si512();
+  // La ultima vuelta carga con mascara, sin leer mas alla de las palabras completas
+  for (size_t k = 0; k < completas; k += 8) {
+    __mmask8 carga = completas - k >= 8 ? 0xFF : (__mmask8)((1u << (completas - k)) - 1);
+    __m512i d = _mm512_xor_si512(_mm512_maskz_loadu_epi64(carga, x + k), _mm512_maskz_loadu_epi64(carga, y + k));
+    d = _mm512_and_si512(_mm512_or_si512(d, _mm512_maskz_srli_epi64(carga, d, 1)), pares);
+    acumulado = _mm512_add_epi64(acumulado, _mm512_popcnt_epi64(d));
+  }
+  uint64_t parciales[8];
+  _mm512_storeu_si512(parciales, acumulado);
+  size_t total = 0;
+  for (uint64_t p : parciales)
+    total += p;
+  if (bases % 32)
+    total += _mm_popcnt_u64(basesDistintas(x[completas], y[completas]) & ((1ULL << 2 * (bases % 32)) - 1));
+  return total;
+}
+
+using FuncionSustituciones = size_t (*)(const uint64_t *, const uint64_t *, size_t);
+
+struct VarianteSustituciones {
+  const char *nombre;
+  FuncionSustituciones funcion;
+};
+
+// Variante enlazada segun nivelSIMD(); VPOPCNTQ es una extension aparte de AVX-512 y POPCNT no es
+// vectorial, asi que se usa tambien en el nivel escalar si la CPU lo tiene
+static const VarianteSustituciones &varianteSustituciones() {
+  static const VarianteSustituciones elegida =
+      nivelSIMD() >= NivelSIMD::AVX512 && __builtin_cpu_supports("avx512vpopcntdq")
+          ? VarianteSustituciones{"avx512", sustitucionesAVX512}
+      : nivelSIMD() >= NivelSIMD::AVX2 ? VarianteSustituciones{"avx2", sustitucionesAVX2}
+      : __builtin_cpu_supports("popcnt") ? VarianteSustituciones{"popcnt", sustitucionesPopcnt}
+                                         : VarianteSustituciones{"popcount", sustitucionesEscalar};
+  return elegida;
+}
+
+static FuncionSustituciones funcionSustituciones() { return varianteSustituciones().funcion; }
+
+// Secuencia empaquetada. Si tiene caracteres fuera de ACGT (N, minusculas...) se guarda el texto tal
+// cual y los scores vuelven a la comparacion caracter por caracter, con el mismo resultado.
+class SecuenciaEmpaquetada {
+public:
+  explicit SecuenciaEmpaquetada(const string &s) : n(s.length()) {
+    if (!empaquetarBases(s, palabras))
+      texto = s;
+  }
+
+  size_t longitud() const { return n; }
+  bool empaquetada() const { return texto.empty(); }
+  const uint64_t *datos() const { return palabras.data(); }
+  string cadena() const { return empaquetada() ? desempaquetarBases(palabras.data(), n) : texto; }
+
+private:
+  size_t n;
+  vector<uint64_t> palabras;
+  string texto;
+};
+
+// calcularScoreSimple sobre secuencias ya empaquetadas
+int calcularScoreSimple(const SecuenciaEmpaquetada &s1, const SecuenciaEmpaquetada &s2) {
+  if (!s1.empaquetada() || !s2.empaquetada())
+    return calcularScoreSimple(s1.cadena(), s2.cadena());
+  long long n1 = s1.longitud(), n2 = s2.longitud();
+  long long L = min(n1, n2);
+  return L - 3 * (long long)funcionSustituciones()(s1.datos(), s2.datos(), L) - 2 * llabs(n1 - n2);
+}
+
+// Base de secuencias empaquetadas una tras otra en un unico arreglo (cada una empieza en palabra nueva),
+// para recorrerla de punta a punta en una sola pasada secuencial
+class BaseEmpaquetada {
+public:
+  void agregar(const string &s) {
+    inicios.push_back(palabras.size());
+    longitudes.push_back(s.length());
+    if (empaquetarBases(s, palabras)) {
+      indiceTexto.push_back(-1);
+    } else {
+      indiceTexto.push_back(textos.size());
+      textos.push_back(s);
+    }
+  }
+
+  size_t cantidad() const { return longitudes.size(); }
+  size_t bytes() const { return palabras.size() * sizeof(uint64_t); }
+  string cadena(size_t k) const {
+    return indiceTexto[k] < 0 ? desempaquetarBases(palabras.data() + inicios[k], longitudes[k])
+                              : textos[indiceTexto[k]];
+  }
+
+  // scores[k] = calcularScoreSimple(consulta, secuencia k) para todas las secuencias de la base
+  void calcularScores(const SecuenciaEmpaquetada &consulta, vector<int> &scores,
+                      FuncionSustituciones sustituciones = funcionSustituciones()) const {
+    scores.resize(cantidad());
+    // Con una consulta fuera de ACGT toda la base se compara caracter por caracter
+    string textoConsulta = consulta.cadena();
+    for (size_t k = 0; k < cantidad(); ++k) {
+      if (indiceTexto[k] >= 0 || !consulta.empaquetada()) {
+        scores[k] = calcularScoreSimple(textoConsulta, cadena(k));
+        continue;
+      }
+      long long n1 = consulta.longitud(), n2 = longitudes[k];
+      long long L = min(n1, n2);
+      scores[k] =
+          L - 3 * (long long)sustituciones(consulta.datos(), palabras.data() + inicios[k], L) - 2 * llabs(n1 - n2);
+    }
+  }
+
+private:
+  vector<uint64_t> palabras;
+  vector<size_t> inicios;
+  vector<uint32_t> longitudes;
+  vector<int> indiceTexto; // -1 si esta empaquetada; si no, posicion en 'textos'
+  vector<string> textos;
+};
 
 // Estructura para los resultados del alineamiento
 struct ResultadoAlineamiento {
   int scoreFinal;
-  vector<vector<int>> matrizScores;
-  int cantidadAlineamientos;
-  vector<pair<string, string>> alineamientosGenerados;
+  MatrizScores matrizScores;
+  unsigned long long cantidadAlineamientos; // contado por DP, no por enumeracion
+  bool cantidadSaturada;                     // true si la cantidad supera el rango de 64 bits
+  vector<Cigar> alineamientosGenerados;
 };
 
 // Imprimir matriz
-void imprimirMatriz(const vector<vector<int>> &matriz) {
-  for (const auto &fila : matriz) {
-    for (int val : fila) {
-      cout << setw(4) << val << " ";
+void imprimirMatriz(const MatrizScores &matriz) {
+  for (int i = 0; i < matriz.filas(); ++i) {
+    for (int j = 0; j < matriz.columnas(); ++j) {
+      cout << setw(4) << matriz(i, j) << " ";
     }
     cout << endl;
   }
 }
 
-// Función reconstruir para encontrar todos los alineamientos óptimos
-void reconstruir(const string &s1, const string &s2, const vector<vector<int>> &matriz, int i, int j, string alin1,
-                 string alin2, vector<pair<string, string>> &alineamientos) {
-  if (i == 0 && j == 0) {
-    reverse(alin1.begin(), alin1.end());
-    reverse(alin2.begin(), alin2.end());
-    alineamientos.push_back({alin1, alin2});
-    return;
+// Direcciones que alcanzan el maximo de una celda
+static inline uint8_t direccionesOptimas(int scoreDiagonal, int scoreArriba, int scoreIzquierda, int mejor) {
+  return (scoreDiagonal == mejor ? MatrizTraceback::DIAGONAL : 0) |
+         (scoreArriba == mejor ? MatrizTraceback::ARRIBA : 0) |
+         (scoreIzquierda == mejor ? MatrizTraceback::IZQUIERDA : 0);
+}
+
+// Iterador perezoso sobre los alineamientos globales optimos, en el mismo orden que la reconstruccion
+// recursiva (diagonal, arriba, izquierda). Recorre el traceback con una pila explicita y un unico buffer
+// de camino compartido: cada llamada a siguiente() produce un alineamiento sin copiar cadenas por celda
+// y sin recursion, asi que la profundidad no depende de la longitud del alineamiento.
+class IteradorAlineamientos {
+public:
+  IteradorAlineamientos(const string &s1, const string &s2, const MatrizTraceback &traceback)
+      : s1(s1), s2(s2), traceback(traceback) {}
+
+  // Escribe el siguiente alineamiento optimo; retorna false cuando ya no quedan
+  bool siguiente(Cigar &alineamiento) {
+    if (!iniciado) {
+      iniciado = true;
+      int n = s1.length(), m = s2.length();
+      pila.push_back({n, m, traceback.direcciones(n, m)});
+    } else if (!pila.empty()) {
+      retroceder(); // descartar la celda (0,0) del alineamiento anterior
+    }
+
+    while (!pila.empty()) {
+      Marco &tope = pila.back();
+      if (tope.i == 0 && tope.j == 0) {
+        alineamiento.limpiar();
+        for (auto it = camino.rbegin(); it != camino.rend(); ++it)
+          alineamiento.agregar(*it);
+        return true;
+      }
+      if (tope.pendientes == 0) {
+        retroceder();
+        continue;
+      }
+
+      int i = tope.i, j = tope.j;
+      if (tope.pendientes & MatrizTraceback::DIAGONAL) {
+        tope.pendientes &= ~MatrizTraceback::DIAGONAL;
+        avanzar(s1[i - 1] == s2[j - 1] ? '=' : 'X', i - 1, j - 1);
+      } else if (tope.pendientes & MatrizTraceback::ARRIBA) {
+        tope.pendientes &= ~MatrizTraceback::ARRIBA;
+        avanzar('D', i - 1, j);
+      } else {
+        tope.pendientes &= ~MatrizTraceback::IZQUIERDA;
+        avanzar('I', i, j - 1);
+      }
+    }
+    return false;
   }
 
-  int scoreActual = matriz[i][j];
-  int scoreDiagonal = (i > 0 && j > 0) ? matriz[i - 1][j - 1] : -1e9; // Un valor muy pequeño si está fuera de límites
-  int scoreArriba = (i > 0) ? matriz[i - 1][j] : -1e9;
-  int scoreIzquierda = (j > 0) ? matriz[i][j - 1] : -1e9;
+private:
+  struct Marco {
+    int i;
+    int j;
+    uint8_t pendientes; // direcciones aun no exploradas desde esta celda
+  };
+
+  void avanzar(char operacion, int i, int j) {
+    camino += operacion;
+    pila.push_back({i, j, traceback.direcciones(i, j)});
+  }
 
-  // Camino diagonal
-  if (i > 0 && j > 0 && scoreActual == scoreDiagonal + (s1[i - 1] == s2[j - 1] ? MATCH : MISMATCH)) {
-    reconstruir(s1, s2, matriz, i - 1, j - 1, alin1 + s1[i - 1], alin2 + s2[j - 1], alineamientos);
+  void retroceder() {
+    pila.pop_back();
+    if (!pila.empty()) {
+      camino.pop_back();
+    }
   }
 
-  // Camino desde arriba
-  if (i > 0 && scoreActual == scoreArriba + GAP) {
-    reconstruir(s1, s2, matriz, i - 1, j, alin1 + s1[i - 1], alin2 + '-', alineamientos);
+  const string &s1;
+  const string &s2;
+  const MatrizTraceback &traceback;
+  vector<Marco> pila;
+  string camino; // operaciones CIGAR del camino actual, desde (n,m) hacia atras
+  bool iniciado = false;
+};
+
+// Genera a lo sumo 'limite' alineamientos optimos
+vector<Cigar> primerosAlineamientos(const string &s1, const string &s2, const MatrizTraceback &traceback,
+                                    size_t limite) {
+  vector<Cigar> alineamientos;
+  IteradorAlineamientos iterador(s1, s2, traceback);
+  Cigar alineamiento;
+  while (alineamientos.size() < limite && iterador.siguiente(alineamiento)) {
+    alineamientos.push_back(alineamiento);
   }
+  return alineamientos;
+}
+
+// Cantidad de alineamientos optimos
+struct ConteoAlineamientos {
+  unsigned long long cantidad;
+  bool saturado;
+};
 
-  // Camino desde la izquierda
-  if (j > 0 && scoreActual == scoreIzquierda + GAP) {
-    reconstruir(s1, s2, matriz, i, j - 1, alin1 + '-', alin2 + s2[j - 1], alineamientos);
+static inline unsigned long long sumaSaturada(unsigned long long a, unsigned long long b) {
+  return a > ULLONG_MAX - b ? ULLONG_MAX : a + b;
+}
+
+// Cuenta los caminos optimos de (0,0) a (n,m) sumando, celda por celda, los conteos de sus predecesores
+// en el traceback. Cuesta O(n*m) con dos filas de contadores de 64 bits que se saturan en vez de desbordarse.
+ConteoAlineamientos contarAlineamientosOptimos(const MatrizTraceback &traceback, int n, int m) {
+  vector<unsigned long long> anterior(m + 1, 1), actual(m + 1);
+  for (int i = 1; i <= n; ++i) {
+    actual[0] = 1;
+    for (int j = 1; j <= m; ++j) {
+      uint8_t direcciones = traceback.direcciones(i, j);
+      unsigned long long cuenta = 0;
+      if (direcciones & MatrizTraceback::DIAGONAL)
+        cuenta = sumaSaturada(cuenta, anterior[j - 1]);
+      if (direcciones & MatrizTraceback::ARRIBA)
+        cuenta = sumaSaturada(cuenta, anterior[j]);
+      if (direcciones & MatrizTraceback::IZQUIERDA)
+        cuenta = sumaSaturada(cuenta, actual[j - 1]);
+      actual[j] = cuenta;
+    }
+    swap(anterior, actual);
   }
+  return {anterior[m], anterior[m] == ULLONG_MAX};
 }
 
-// Implementación del alineamiento global (Needleman-Wunch)
-ResultadoAlineamiento alineamientoGlobal(const string &s1, const string &s2) {
+// Muestrea k alineamientos optimos de forma uniforme: desde (n,m) se elige cada predecesor con probabilidad
+// proporcional a la cantidad de caminos optimos que llegan a el. Esa cantidad crece exponencialmente (no cabe
+// ni en double para pares largos y repetitivos), asi que se lleva su log2 en dos filas rotativas y cada celda
+// guarda solo sus umbrales acumulados (diagonal, diagonal + arriba) cuantizados a 16 bits: O(n*m) celdas de
+// 4 bytes, la mitad que con conteos double y sin desborde. La cuantizacion aleja cada eleccion de la
+// proporcion exacta en a lo sumo 2^-17, de modo que el muestreo es uniforme salvo ese error por bifurcacion.
+vector<Cigar> muestrearAlineamientosOptimos(const string &s1, const string &s2, const MatrizTraceback &traceback,
+                                            int k, mt19937 &generador) {
+  const double ESCALA = 65535.0;
   int n = s1.length();
   int m = s2.length();
+  size_t ancho = m + 1;
+  // Fila 0: siempre a la izquierda (umbrales 0, 0); columna 0: siempre arriba (umbrales 0, 65535)
+  vector<uint32_t> umbrales((size_t)(n + 1) * ancho, 0);
+  vector<double> anterior(m + 1, 0.0), actual(m + 1); // log2 de la cantidad de caminos; el borde tiene uno
+  for (int i = 1; i <= n; ++i) {
+    umbrales[i * ancho] = 0xFFFFu << 16;
+    actual[0] = 0.0;
+    for (int j = 1; j <= m; ++j) {
+      uint8_t direcciones = traceback.direcciones(i, j);
+      double logDiagonal = (direcciones & MatrizTraceback::DIAGONAL) ? anterior[j - 1] : -HUGE_VAL;
+      double logArriba = (direcciones & MatrizTraceback::ARRIBA) ? anterior[j] : -HUGE_VAL;
+      double logIzquierda = (direcciones & MatrizTraceback::IZQUIERDA) ? actual[j - 1] : -HUGE_VAL;
+      double mayor = max({logDiagonal, logArriba, logIzquierda});
+      double pesoDiagonal = exp2(logDiagonal - mayor);
+      double pesoArriba = exp2(logArriba - mayor);
+      double total = pesoDiagonal + pesoArriba + exp2(logIzquierda - mayor);
+      actual[j] = mayor + log2(total);
+      uint32_t umbralDiagonal = lround(pesoDiagonal / total * ESCALA);
+      uint32_t umbralArriba = lround((pesoDiagonal + pesoArriba) / total * ESCALA);
+      umbrales[i * ancho + j] = umbralDiagonal | umbralArriba << 16;
+    }
+    swap(anterior, actual);
+  }
 
-  vector<vector<int>> matriz(n + 1, vector<int>(m + 1));
+  vector<Cigar> muestras;
+  uniform_real_distribution<double> azar(0.0, ESCALA);
+  for (int muestra = 0; muestra < k; ++muestra) {
+    Cigar alineamiento;
+    int i = n, j = m;
+    while (i > 0 || j > 0) {
+      // Un umbral solo supera al anterior si su direccion esta en el traceback
+      uint32_t umbral = umbrales[i * ancho + j];
+      double x = azar(generador);
+      if (x < (umbral & 0xFFFF)) {
+        alineamiento.agregarPar(s1[--i], s2[--j]);
+      } else if (x < (umbral >> 16)) {
+        alineamiento.agregar('D');
+        --i;
+      } else {
+        alineamiento.agregar('I');
+        --j;
+      }
+    }
+    alineamiento.invertir();
+    muestras.push_back(alineamiento);
+  }
+  return muestras;
+}
 
-  // Inicializar la matriz de scores
-  for (int i = 0; i <= n; ++i) {
-    matriz[i][0] = i * GAP;
+// Implementación del alineamiento global (Needleman-Wunch). Las filas de scores rotan y solo se guarda
+// la matriz de traceback compacta; la matriz completa de scores (O(n*m) enteros) se conserva solo si
+// guardarMatriz, que por defecto es false: solo la piden quienes la imprimen o la vuelcan.
+// La cantidad de alineamientos optimos se cuenta por DP y solo se generan los primeros maxAlineamientos.
+// P es la politica de puntuacion; con gaps afines se usa alineamientoGlobalAfin.
+template <class P> ResultadoAlineamiento alineamientoGlobalAfin(const string &s1, const string &s2);
+
+template <class P = PuntuacionEstandar>
+ResultadoAlineamiento alineamientoGlobal(const string &s1, const string &s2, bool guardarMatriz = false,
+                                         size_t maxAlineamientos = 1000) {
+  if constexpr (P::esAfin) {
+    return alineamientoGlobalAfin<P>(s1, s2);
   }
+  int n = s1.length();
+  int m = s2.length();
+
+  MatrizTraceback traceback(n, m);
+  vector<int> anterior(m + 1), actual(m + 1);
+  ResultadoAlineamiento resultado;
+
+  // Inicializar la primera fila de scores
   for (int j = 0; j <= m; ++j) {
-    matriz[0][j] = j * GAP;
+    anterior[j] = j * P::extension;
+  }
+  if (guardarMatriz) {
+    resultado.matrizScores.redimensionar(n + 1, m + 1);
+    copy(anterior.begin(), anterior.end(), resultado.matrizScores.fila(0));
   }
 
   // Llenar la matriz de scores
   for (int i = 1; i <= n; ++i) {
+    actual[0] = i * P::extension;
     for (int j = 1; j <= m; ++j) {
-      int scoreDiagonal = matriz[i - 1][j - 1] + (s1[i - 1] == s2[j - 1] ? MATCH : MISMATCH);
-      int scoreArriba = matriz[i - 1][j] + GAP;
-      int scoreIzquierda = matriz[i][j - 1] + GAP;
-      matriz[i][j] = max({scoreDiagonal, scoreArriba, scoreIzquierda});
+      int scoreDiagonal = anterior[j - 1] + P::sustitucion(s1[i - 1], s2[j - 1]);
+      int scoreArriba = anterior[j] + P::extension;
+      int scoreIzquierda = actual[j - 1] + P::extension;
+      actual[j] = max({scoreDiagonal, scoreArriba, scoreIzquierda});
+      traceback.marcar(i, j, direccionesOptimas(scoreDiagonal, scoreArriba, scoreIzquierda, actual[j]));
     }
+    if (guardarMatriz) {
+      copy(actual.begin(), actual.end(), resultado.matrizScores.fila(i));
+    }
+    swap(anterior, actual);
   }
 
-  ResultadoAlineamiento resultado;
-  resultado.scoreFinal = matriz[n][m];
-  resultado.matrizScores = matriz;
+  resultado.scoreFinal = anterior[m];
+
+  ConteoAlineamientos conteo = contarAlineamientosOptimos(traceback, n, m);
+  resultado.cantidadAlineamientos = conteo.cantidad;
+  resultado.cantidadSaturada = conteo.saturado;
 
   // Realizar reconstruccion para obtener los alineamientos
-  vector<pair<string, string>> alineamientos;
-  reconstruir(s1, s2, matriz, n, m, "", "", alineamientos);
-  resultado.alineamientosGenerados = alineamientos;
-  resultado.cantidadAlineamientos = alineamientos.size();
+  resultado.alineamientosGenerados = primerosAlineamientos(s1, s2, traceback, maxAlineamientos);
+
+  return resultado;
+}
+
+// Alineamiento global con gaps afines en memoria lineal (Gotoh + Myers-Miller). No hay matriz de scores
+// ni conteo de co-optimos: se reconstruye un alineamiento optimo y cantidadAlineamientos vale 1.
+template <class P> ResultadoAlineamiento alineamientoGlobalAfin(const string &s1, const string &s2) {
+  ResultadoAlineamiento resultado;
+  Cigar alineamiento;
+  hirschbergAfin<P>(s1.data(), s1.length(), s2.data(), s2.length(), P::apertura, P::apertura, alineamiento);
+  resultado.scoreFinal = puntuarCigar<P>(alineamiento, s1, s2);
+  resultado.cantidadAlineamientos = 1;
+  resultado.cantidadSaturada = false;
+  resultado.alineamientosGenerados.push_back(alineamiento);
+  return resultado;
+}
+
+// Alineamiento global con el esquema de puntuacion elegido en tiempo de ejecucion
+ResultadoAlineamiento alineamientoGlobal(const string &s1, const string &s2, EsquemaPuntuacion esquema,
+                                         bool guardarMatriz = false, size_t maxAlineamientos = 1000) {
+  switch (esquema) {
+  case EsquemaPuntuacion::Transiciones:
+    return alineamientoGlobal<PuntuacionTransiciones>(s1, s2, guardarMatriz, maxAlineamientos);
+  case EsquemaPuntuacion::Blastn:
+    return alineamientoGlobalAfin<PuntuacionBlastn>(s1, s2);
+  default:
+    return alineamientoGlobal<PuntuacionEstandar>(s1, s2, guardarMatriz, maxAlineamientos);
+  }
+}
+
+// Kernel de diferencias (Suzuki-Kasahara) para el score del alineamiento global.
+// En vez de H(i,j) se guardan dV(i,j) = H(i,j) - H(i-1,j) y dH(i,j) = H(i,j) - H(i,j-1),
+// acotados en [GAP, MATCH - GAP], por lo que caben en int8 sin importar la longitud.
+// Se recorre por antidiagonales: las celdas de una antidiagonal son independientes.
+static_assert(MATCH - GAP <= 127 && 2 * GAP >= -128, "Las diferencias deben caber en int8");
 
+// Procesa las celdas i en [ini, fin] de una antidiagonal (version escalar)
+static void deltaDiagonalEscalar(const int8_t *a, const int8_t *bRev, int desplB, int8_t *dV, const int8_t *dHPrev,
+                                 int8_t *dHAct, int ini, int fin) {
+  for (int i = ini; i <= fin; ++i) {
+    int s = (a[i - 1] == bRev[desplB + i]) ? MATCH : MISMATCH;
+    int z = max(s, max<int>(dV[i], dHPrev[i - 1]) + GAP); // z = H(i,j) - H(i-1,j-1)
+    int8_t dVNuevo = z - dHPrev[i - 1];
+    dHAct[i] = z - dV[i];
+    dV[i] = dVNuevo;
+  }
+}
+
+// Misma recurrencia con 32 celdas int8 por instruccion (AVX2)
+__attribute__((target("avx2"))) static void deltaDiagonalAVX2(const int8_t *a, const int8_t *bRev, int desplB,
+                                                               int8_t *dV, const int8_t *dHPrev, int8_t *dHAct,
+                                                               int ini, int fin) {
+  const __m256i vMatch = _mm256_set1_epi8(MATCH);
+  const __m256i vMismatch = _mm256_set1_epi8(MISMATCH);
+  const __m256i vGap = _mm256_set1_epi8(GAP);
+  int i = ini;
+  for (; i + 31 <= fin; i += 32) {
+    __m256i ca = _mm256_loadu_si256((const __m256i *)(a + i - 1));
+    __m256i cb = _mm256_loadu_si256((const __m256i *)(bRev + desplB + i));
+    __m256i s = _mm256_blendv_epi8(vMismatch, vMatch, _mm256_cmpeq_epi8(ca, cb));
+    __m256i v = _mm256_loadu_si256((const __m256i *)(dV + i));
+    __m256i h = _mm256_loadu_si256((const __m256i *)(dHPrev + i - 1));
+    __m256i z = _mm256_max_epi8(s, _mm256_add_epi8(_mm256_max_epi8(v, h), vGap));
+    _mm256_storeu_si256((__m256i *)(dHAct + i), _mm256_sub_epi8(z, v));
+    _mm256_storeu_si256((__m256i *)(dV + i), _mm256_sub_epi8(z, h));
+  }
+  deltaDiagonalEscalar(a, bRev, desplB, dV, dHPrev, dHAct, i, fin);
+}
+
+// Score del alineamiento global usando el kernel de diferencias (sin matriz ni traceback).
+// El score exacto se reconstruye como H(0,m) + suma de dV(i,m).
+int alineamientoGlobalScoreDelta(const string &s1, const string &s2) {
+  int n = s1.length();
+  int m = s2.length();
+  string s2Rev(s2.rbegin(), s2.rend());
+  const int8_t *a = (const int8_t *)s1.data();
+  const int8_t *bRev = (const int8_t *)s2Rev.data();
+
+  // dV[i] y dH[i] corresponden a la celda de la fila i en la antidiagonal actual
+  vector<int8_t> dV(n + 1, GAP), dHPrev(n + 1, GAP), dHAct(n + 1, GAP);
+  static const auto diagonal = nivelSIMD() >= NivelSIMD::AVX2 ? deltaDiagonalAVX2 : deltaDiagonalEscalar;
+
+  for (int d = 2; d <= n + m; ++d) {
+    int ini = max(1, d - m);
+    int fin = min(n, d - 1);
+    // s2[j-1] con j = d - i equivale a s2Rev[m - d + i]
+    diagonal(a, bRev, m - d, dV.data(), dHPrev.data(), dHAct.data(), ini, fin);
+    swap(dHPrev, dHAct);
+  }
+
+  int score = m * GAP;
+  for (int i = 1; i <= n; ++i) {
+    score += dV[i];
+  }
+  return score;
+}
+
+// Score del alineamiento global con la politica P, en memoria O(m). La politica estandar va al kernel de
+// diferencias int8 (el camino rapido para pares largos); con politicas afines se usa el kernel de Gotoh
+// (filaFinalAfin, con variante AVX2) y se queda con la ultima celda de su fila final.
+template <class P> int alineamientoGlobalScore(const string &s1, const string &s2) {
+  if constexpr (is_same_v<P, PuntuacionEstandar>)
+    return alineamientoGlobalScoreDelta(s1, s2);
+  int n = s1.length();
+  int m = s2.length();
+  vector<int> H(m + 1);
+  if constexpr (P::esAfin) {
+    vector<int> E(m + 1);
+    filaFinalAfin<P>(s1.data(), n, s2.data(), m, P::apertura, H.data(), E.data());
+    return H[m];
+  }
+  for (int j = 0; j <= m; ++j)
+    H[j] = j * P::extension;
+
+  for (int i = 1; i <= n; ++i) {
+    int diagonal = H[0];
+    H[0] = i * P::extension;
+    for (int j = 1; j <= m; ++j) {
+      int scoreDiagonal = diagonal + P::sustitucion(s1[i - 1], s2[j - 1]);
+      diagonal = H[j];
+      H[j] = max({scoreDiagonal, H[j] + P::extension, H[j - 1] + P::extension});
+    }
+  }
+  return H[m];
+}
+
+// Score del alineamiento global con el esquema elegido en tiempo de ejecucion
+int alineamientoGlobalScore(const string &s1, const string &s2, EsquemaPuntuacion esquema) {
+  switch (esquema) {
+  case EsquemaPuntuacion::Transiciones:
+    return alineamientoGlobalScore<PuntuacionTransiciones>(s1, s2);
+  case EsquemaPuntuacion::Blastn:
+    return alineamientoGlobalScore<PuntuacionBlastn>(s1, s2);
+  default:
+    return alineamientoGlobalScore<PuntuacionEstandar>(s1, s2);
+  }
+}
+
+// Resultado del alineamiento global en banda
+struct ResultadoBanda {
+  int scoreFinal;
+  bool optimo;   // true si se demuestra que ningun camino fuera de la banda supera el score
+  bool abortado; // true si el X-drop detuvo el calculo (par sin similitud suficiente)
+  int anchoBanda;
+  Cigar alineamiento;
+};
+
+// Cota superior (multiplicada por 2) del score de cualquier camino de (i,j) a (n,m): necesita al menos
+// |(n - i) - (m - j)| gaps y el resto de columnas aportan a lo sumo MATCH.
+static long long cotaDobleSufijo(int n, int m, int i, int j) {
+  long long gaps = abs((n - i) - (m - j));
+  return (long long)MATCH * ((n - i) + (m - j) - gaps) + 2LL * GAP * gaps;
+}
+
+// Un intento de relleno con semi-ancho w. La ventana de la fila i se centra en la columna siguiente
+// a la mejor celda de la fila i-1, de modo que la banda sigue la diagonal de mejor score.
+static void rellenarBanda(const string &s1, const string &s2, int w, int xDrop, ResultadoBanda &res,
+                          bool &tocaBorde) {
+  int n = s1.length();
+  int m = s2.length();
+  vector<int> ini(n + 1), fin(n + 1);
+  vector<vector<int>> filas(n + 1);
+  int mejorVisto = 0;
+
+  auto valor = [&](int i, int j) { return (j >= ini[i] && j <= fin[i]) ? filas[i][j - ini[i]] : MENOS_INFINITO; };
+
+  ini[0] = 0;
+  fin[0] = min(m, w);
+  filas[0].resize(fin[0] + 1);
+  for (int j = 0; j <= fin[0]; ++j)
+    filas[0][j] = j * GAP;
+
+  int mejorColumna = 0;
+  for (int i = 1; i <= n; ++i) {
+    int centro = mejorColumna + 1;
+    ini[i] = max(0, centro - w);
+    fin[i] = min(m, centro + w);
+    filas[i].assign(fin[i] - ini[i] + 1, MENOS_INFINITO);
+
+    int mejorFila = MENOS_INFINITO;
+    for (int j = ini[i]; j <= fin[i]; ++j) {
+      int mejor = valor(i - 1, j) + GAP;
+      if (j > 0) {
+        mejor = max(mejor, valor(i - 1, j - 1) + (s1[i - 1] == s2[j - 1] ? MATCH : MISMATCH));
+        if (j > ini[i])
+          mejor = max(mejor, filas[i][j - 1 - ini[i]] + GAP);
+      }
+      filas[i][j - ini[i]] = mejor;
+      if (mejor > mejorFila) {
+        mejorFila = mejor;
+        mejorColumna = j;
+      }
+    }
+
+    // X-drop: si toda la fila cae X por debajo del mejor score visto, el par no tiene remedio
+    mejorVisto = max(mejorVisto, mejorFila);
+    if (xDrop >= 0 && mejorFila < mejorVisto - xDrop) {
+      res.abortado = true;
+      return;
+    }
+  }
+
+  if (m < ini[n] || m > fin[n]) {
+    tocaBorde = true; // la banda no alcanzo la esquina final
+    return;
+  }
+
+  res.scoreFinal = valor(n, m);
+
+  // Todo camino que sale de la banda lo hace desde una celda (i,j) de la banda hacia un sucesor fuera de ella.
+  // Su prefijo vale a lo sumo H(i,j) (el mejor dentro de la banda) y su sufijo a lo sumo cotaDobleSufijo.
+  long long cotaFuera = numeric_limits<long long>::min();
+  auto fuera = [&](int i, int j) { return j <= m && (j < ini[i] || j > fin[i]); };
+  for (int i = 0; i <= n; ++i) {
+    for (int j = ini[i]; j <= fin[i]; ++j) {
+      long long prefijo = 2LL * filas[i][j - ini[i]];
+      if (fuera(i, j + 1))
+        cotaFuera = max(cotaFuera, prefijo + 2LL * GAP + cotaDobleSufijo(n, m, i, j + 1));
+      if (i < n && fuera(i + 1, j))
+        cotaFuera = max(cotaFuera, prefijo + 2LL * GAP + cotaDobleSufijo(n, m, i + 1, j));
+      if (i < n && fuera(i + 1, j + 1))
+        cotaFuera = max(cotaFuera, prefijo + 2LL * MATCH + cotaDobleSufijo(n, m, i + 1, j + 1));
+    }
+  }
+  res.optimo = 2LL * res.scoreFinal >= cotaFuera;
+
+  // Traceback dentro de la banda, con la misma preferencia que el iterador de alineamientos (diagonal, arriba,
+  // izquierda)
+  Cigar &cigar = res.alineamiento;
+  int i = n, j = m;
+  while (i > 0 || j > 0) {
+    if ((j == ini[i] && ini[i] > 0) || (j == fin[i] && fin[i] < m))
+      tocaBorde = true;
+    int actual = valor(i, j);
+    if (i > 0 && j > 0 && actual == valor(i - 1, j - 1) + (s1[i - 1] == s2[j - 1] ? MATCH : MISMATCH)) {
+      cigar.agregarPar(s1[--i], s2[--j]);
+    } else if (i > 0 && actual == valor(i - 1, j) + GAP) {
+      cigar.agregar('D');
+      --i;
+    } else {
+      cigar.agregar('I');
+      --j;
+    }
+  }
+  cigar.invertir();
+}
+
+// Alineamiento global en banda adaptativa. Cuesta O(n*w) en vez de O(n*m); la banda se duplica
+// mientras el camino optimo toque su borde (o mientras no sea demostrablemente optimo si exigirOptimo).
+// xDrop < 0 desactiva la terminacion temprana.
+ResultadoBanda alineamientoGlobalBanda(const string &s1, const string &s2, int anchoInicial = 16, int xDrop = -1,
+                                       bool exigirOptimo = false) {
+  int m = s2.length();
+  int w = max(1, anchoInicial);
+  while (true) {
+    ResultadoBanda res{MENOS_INFINITO, false, false, w, {}};
+    bool tocaBorde = false;
+    rellenarBanda(s1, s2, w, xDrop, res, tocaBorde);
+    // Con w > m todas las ventanas cubren la fila completa y el resultado es exacto
+    bool bandaCompleta = w > m;
+    if (res.abortado || bandaCompleta) {
+      res.optimo = !res.abortado;
+      return res;
+    }
+    if (!tocaBorde && (res.optimo || !exigirOptimo)) {
+      return res;
+    }
+    w *= 2;
+  }
+}
+
+// Alineamiento global por frentes de onda (WFA). Con match M, mismatch X y gap G, todo alineamiento de
+// s1 y s2 cumple score = ((n + m) * M - P) / 2, donde P cuenta 2*(M - X) por mismatch y (M - 2*G) por gap
+// y 0 por match. Minimizar P es equivalente a maximizar el score, y el costo crece con P, no con n*m.
+const int WFA_MISMATCH = 2 * (MATCH - MISMATCH);
+const int WFA_GAP = MATCH - 2 * GAP;
+static_assert(WFA_MISMATCH > 0 && WFA_GAP > 0, "WFA requiere penalizaciones positivas");
+
+// Resultado del alineamiento global por frentes de onda
+struct ResultadoWFA {
+  int scoreFinal;
+  int penalizacion;
+  Cigar alineamiento;
+};
+
+// Frente de onda de una penalizacion: offsets (columna j) por diagonal k = j - i en [kMin, kMax]
+struct FrenteOnda {
+  bool vacio = true;
+  int kMin = 0;
+  int kMax = -1;
+  vector<int> offsets;
+  int offset(int k) const { return (vacio || k < kMin || k > kMax) ? MENOS_INFINITO : offsets[k - kMin]; }
+};
+
+ResultadoWFA alineamientoGlobalWFA(const string &s1, const string &s2) {
+  int n = s1.length();
+  int m = s2.length();
+  int kFinal = m - n;
+  vector<FrenteOnda> frentes;
+
+  // Un offset es valido si la celda (j - k, j) cae dentro de la matriz
+  auto valido = [&](int k, int o) { return o >= 0 && o <= m && o - k >= 0 && o - k <= n; };
+  auto extender = [&](int k, int &o) {
+    while (o < m && o - k < n && s1[o - k] == s2[o])
+      ++o;
+  };
+
+  int p = 0;
+  while (true) {
+    FrenteOnda actual;
+    if (p == 0) {
+      actual = {false, 0, 0, {0}};
+    } else {
+      const FrenteOnda *mis = p >= WFA_MISMATCH ? &frentes[p - WFA_MISMATCH] : nullptr;
+      const FrenteOnda *gap = p >= WFA_GAP ? &frentes[p - WFA_GAP] : nullptr;
+      bool hayMis = mis && !mis->vacio;
+      bool hayGap = gap && !gap->vacio;
+      if (hayMis || hayGap) {
+        actual.kMin = min(hayMis ? mis->kMin : INT32_MAX, hayGap ? gap->kMin - 1 : INT32_MAX);
+        actual.kMax = max(hayMis ? mis->kMax : INT32_MIN, hayGap ? gap->kMax + 1 : INT32_MIN);
+        actual.offsets.assign(actual.kMax - actual.kMin + 1, MENOS_INFINITO);
+        for (int k = actual.kMin; k <= actual.kMax; ++k) {
+          int o = MENOS_INFINITO;
+          if (hayMis && valido(k, mis->offset(k) + 1))
+            o = max(o, mis->offset(k) + 1); // mismatch: avanza en ambas secuencias
+          if (hayGap && valido(k, gap->offset(k - 1) + 1))
+            o = max(o, gap->offset(k - 1) + 1); // gap en s1: consume un caracter de s2
+          if (hayGap && valido(k, gap->offset(k + 1)))
+            o = max(o, gap->offset(k + 1)); // gap en s2: consume un caracter de s1
+          if (o >= 0) {
+            actual.vacio = false;
+          }
+          actual.offsets[k - actual.kMin] = o;
+        }
+      }
+    }
+    if (!actual.vacio) {
+      for (int k = actual.kMin; k <= actual.kMax; ++k) {
+        int &o = actual.offsets[k - actual.kMin];
+        if (o >= 0)
+          extender(k, o);
+      }
+    }
+    frentes.push_back(actual);
+    if (frentes[p].offset(kFinal) == m)
+      break;
+    ++p;
+  }
+
+  ResultadoWFA resultado;
+  resultado.penalizacion = p;
+  resultado.scoreFinal = ((n + m) * MATCH - p) / 2;
+
+  // Traceback: en cada frente se deshace la extension de matches y se busca el origen del offset
+  Cigar &cigar = resultado.alineamiento;
+  int k = kFinal;
+  int o = m;
+  while (true) {
+    int base = MENOS_INFINITO;
+    int origen = -1;
+    if (p == 0) {
+      base = 0;
+    } else {
+      const FrenteOnda *mis = p >= WFA_MISMATCH ? &frentes[p - WFA_MISMATCH] : nullptr;
+      const FrenteOnda *gap = p >= WFA_GAP ? &frentes[p - WFA_GAP] : nullptr;
+      if (mis && valido(k, mis->offset(k) + 1) && mis->offset(k) + 1 > base) {
+        base = mis->offset(k) + 1;
+        origen = 0;
+      }
+      if (gap && valido(k, gap->offset(k + 1)) && gap->offset(k + 1) > base) {
+        base = gap->offset(k + 1);
+        origen = 1;
+      }
+      if (gap && valido(k, gap->offset(k - 1) + 1) && gap->offset(k - 1) + 1 > base) {
+        base = gap->offset(k - 1) + 1;
+        origen = 2;
+      }
+    }
+    if (o > base) {
+      cigar.agregar('=', o - base);
+      o = base;
+    }
+    if (p == 0)
+      break;
+    if (origen == 0) {
+      cigar.agregarPar(s1[o - k - 1], s2[o - 1]);
+      --o;
+      p -= WFA_MISMATCH;
+    } else if (origen == 1) {
+      cigar.agregar('D');
+      ++k;
+      p -= WFA_GAP;
+    } else {
+      cigar.agregar('I');
+      --o;
+      --k;
+      p -= WFA_GAP;
+    }
+  }
+  cigar.invertir();
   return resultado;
 }
 
-// Función para guardar resultados
-void guardarResultados(const string &nombreArchivo, const ResultadoAlineamiento &resultado) {
+// Variante de cada familia de kernels elegida en esta maquina
+void imprimirDespachoSIMD() {
+  NivelSIMD enUso = nivelSIMD(); // antes de imprimir: puede avisar por cerr
+  const char *antidiagonales = enUso >= NivelSIMD::AVX2 ? "avx2" : "escalar";
+  cout << "SIMD soportado: " << nombreNivelSIMD(nivelSIMDSoportado()) << ", en uso: " << nombreNivelSIMD(enUso) << endl;
+  cout << "  score sin gaps (popcount):  " << varianteSustituciones().nombre << endl;
+  cout << "  Gotoh por antidiagonales:   " << antidiagonales << endl;
+  cout << "  kernel de diferencias:      " << antidiagonales << endl;
+}
+
+// Benchmark: WFA frente a banda adaptativa, matriz completa y kernel de diferencias al crecer la divergencia
+void benchmarkWFA(int longitud) {
+  mt19937 generador(42);
+  string base = generarSecuenciaAleatoria(longitud, generador);
+  cout << "--- Benchmark WFA (longitud " << longitud << ") ---" << endl;
+  cout << setw(12) << "divergencia" << setw(12) << "score" << setw(12) << "completa" << setw(12) << "banda"
+       << setw(12) << "wfa" << setw(12) << "delta" << endl;
+  for (double divergencia : {0.001, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.3}) {
+    string mutada = mutarSecuencia(base, divergencia, generador);
+    ResultadoAlineamiento completa;
+    ResultadoBanda banda;
+    ResultadoWFA wfa;
+    int delta = 0;
+    // Matriz completa con traceback empaquetado; basta un alineamiento para medir el relleno
+    double tCompleta = medirSegundos([&] { completa = alineamientoGlobal(base, mutada, false, 1); });
+    double tBanda = medirSegundos([&] { banda = alineamientoGlobalBanda(base, mutada, 16, -1, true); });
+    double tWFA = medirSegundos([&] { wfa = alineamientoGlobalWFA(base, mutada); });
+    double tDelta = medirSegundos([&] { delta = alineamientoGlobalScoreDelta(base, mutada); });
+    if (wfa.scoreFinal != completa.scoreFinal || banda.scoreFinal != completa.scoreFinal ||
+        delta != completa.scoreFinal) {
+      cerr << "Error: los kernels no coinciden en divergencia " << divergencia << endl;
+    }
+    cout << setw(12) << divergencia << setw(12) << completa.scoreFinal << setw(12) << tCompleta << setw(12) << tBanda
+         << setw(12) << tWFA << setw(12) << tDelta << endl;
+  }
+}
+
+// Benchmark: tamizado de lecturas contra muchos primers con la busqueda ingenua, Two-Way por patron y
+// Aho-Corasick con todos los patrones a la vez
+void benchmarkBusqueda(int numLecturas) {
+  const int NUM_PRIMERS = 500, LONGITUD_PRIMER = 20, LONGITUD_LECTURA = 150;
+  mt19937 generador(11);
+  vector<string> primers, lecturas;
+  for (int p = 0; p < NUM_PRIMERS; ++p)
+    primers.push_back(generarSecuenciaAleatoria(LONGITUD_PRIMER, generador));
+  for (int r = 0; r < numLecturas; ++r) {
+    string lectura = generarSecuenciaAleatoria(LONGITUD_LECTURA, generador);
+    // Una de cada diez lecturas trae un primer insertado
+    if (r % 10 == 0)
+      lectura.replace(generador() % (LONGITUD_LECTURA - LONGITUD_PRIMER), LONGITUD_PRIMER,
+                      primers[generador() % NUM_PRIMERS]);
+    lecturas.push_back(lectura);
+  }
+
+  size_t totalIngenua = 0, totalTwoWay = 0, totalAho = 0;
+  double tIngenua = medirSegundos([&] {
+    for (const auto &lectura : lecturas)
+      for (const auto &primer : primers)
+        for (size_t i = 0; i + primer.length() <= lectura.length(); ++i)
+          totalIngenua += lectura.compare(i, primer.length(), primer) == 0;
+  });
+  vector<BuscadorTwoWay> buscadores(primers.begin(), primers.end());
+  double tTwoWay = medirSegundos([&] {
+    for (const auto &lectura : lecturas)
+      for (const auto &buscador : buscadores)
+        totalTwoWay += buscador.buscar(lectura).size();
+  });
+  double tAho = medirSegundos([&] {
+    AutomataAhoCorasick automata(primers);
+    for (const auto &lectura : lecturas)
+      automata.recorrer(lectura, [&](int, size_t) { ++totalAho; });
+  });
+
+  cout << "--- Benchmark busqueda (" << numLecturas << " lecturas de " << LONGITUD_LECTURA << ", " << NUM_PRIMERS
+       << " primers de " << LONGITUD_PRIMER << ") ---" << endl;
+  cout << setw(16) << "metodo" << setw(14) << "segundos" << setw(14) << "ocurrencias" << endl;
+  cout << setw(16) << "ingenua" << setw(14) << tIngenua << setw(14) << totalIngenua << endl;
+  cout << setw(16) << "two-way" << setw(14) << tTwoWay << setw(14) << totalTwoWay << endl;
+  cout << setw(16) << "aho-corasick" << setw(14) << tAho << setw(14) << totalAho << endl;
+  if (totalTwoWay != totalIngenua || totalAho != totalIngenua)
+    cerr << "Error: los buscadores no coinciden" << endl;
+}
+
+// Benchmark: construccion del indice FM sobre una referencia aleatoria de 'megabases' Mb (tiempo, pico de
+// memoria y tamano), guardado y apertura con mmap, y costo de contar/localizar patrones de 20 bases
+void benchmarkFM(int megabases) {
+  mt19937 generador(5);
+  string referencia = generarSecuenciaAleatoria(megabases * 1000000, generador);
+  cout << "--- Benchmark indice FM (referencia de " << megabases << " Mb) ---" << endl;
+
+  IndiceFM indice;
+  double tConstruccion = medirSegundos([&] { indice.construir(referencia); });
+  struct rusage uso;
+  getrusage(RUSAGE_SELF, &uso);
+  cout << "construccion: " << tConstruccion << " s, pico de memoria: " << uso.ru_maxrss / 1024
+       << " MB, indice: " << indice.bytes() / (1 << 20) << " MB" << endl;
+
+  const string archivo = "indice_fm.bin";
+  IndiceFM proyectado;
+  double tGuardar = medirSegundos([&] { indice.guardar(archivo); });
+  double tAbrir = medirSegundos([&] { proyectado.abrir(archivo); });
+  cout << "guardar: " << tGuardar << " s, abrir (mmap): " << tAbrir << " s" << endl;
+
+  // Mitad de los patrones salen de la referencia y la otra mitad son aleatorios
+  const int CONSULTAS = 100000, LONGITUD = 20;
+  vector<string> patrones;
+  for (int q = 0; q < CONSULTAS; ++q) {
+    if (q % 2 == 0)
+      patrones.push_back(referencia.substr(generador() % (referencia.length() - LONGITUD), LONGITUD));
+    else
+      patrones.push_back(generarSecuenciaAleatoria(LONGITUD, generador));
+  }
+  size_t ocurrencias = 0, localizadas = 0;
+  double tContar = medirSegundos([&] {
+    for (const auto &patron : patrones)
+      ocurrencias += proyectado.contar(patron);
+  });
+  double tLocalizar = medirSegundos([&] {
+    for (const auto &patron : patrones)
+      localizadas += proyectado.localizar(patron).size();
+  });
+  cout << "contar: " << tContar * 1e6 / CONSULTAS << " us/consulta, localizar: " << tLocalizar * 1e6 / CONSULTAS
+       << " us/consulta (" << ocurrencias << " ocurrencias)" << endl;
+
+  // Verificacion contra el recorrido completo de la referencia
+  double tRecorrido = medirSegundos([&] {
+    for (int q = 0; q < 10; ++q) {
+      if (BuscadorTwoWay(patrones[q]).buscar(referencia) != proyectado.localizar(patrones[q]))
+        cerr << "Error: el indice FM no coincide con la busqueda directa" << endl;
+    }
+  });
+  cout << "busqueda directa (Two-Way): " << tRecorrido * 1e6 / 10 << " us/consulta" << endl;
+  if (localizadas != ocurrencias)
+    cerr << "Error: contar y localizar no coinciden" << endl;
+  remove(archivo.c_str());
+}
+
+// Benchmark: busqueda aproximada de un primer (k diferencias) en muchas lecturas con el DP de Sellers
+// columna por columna y con los vectores de bits de Myers (una y varias palabras)
+void benchmarkAproximada(int numLecturas) {
+  const int LONGITUD_LECTURA = 150;
+  mt19937 generador(13);
+  cout << "--- Benchmark busqueda aproximada (" << numLecturas << " lecturas de " << LONGITUD_LECTURA << ") ---"
+       << endl;
+  cout << setw(10) << "patron" << setw(6) << "k" << setw(14) << "sellers" << setw(14) << "myers" << setw(14)
+       << "ns/caracter" << setw(14) << "ocurrencias" << endl;
+  for (int longitudPatron : {20, 100}) {
+    int k = longitudPatron / 10;
+    string patron = generarSecuenciaAleatoria(longitudPatron, generador);
+    vector<string> lecturas;
+    for (int r = 0; r < numLecturas; ++r) {
+      string lectura = generarSecuenciaAleatoria(LONGITUD_LECTURA, generador);
+      // Una de cada diez lecturas trae el patron con un 5% de mutaciones
+      if (r % 10 == 0)
+        lectura.replace(generador() % (LONGITUD_LECTURA - longitudPatron), longitudPatron,
+                        mutarSecuencia(patron, 0.05, generador));
+      lecturas.push_back(lectura);
+    }
+
+    // Referencia: DP de Sellers (fila 0 en cero para que la ocurrencia empiece en cualquier posicion)
+    size_t totalSellers = 0;
+    double tSellers = medirSegundos([&] {
+      vector<int> columna(longitudPatron + 1);
+      for (const auto &lectura : lecturas) {
+        for (int i = 0; i <= longitudPatron; ++i)
+          columna[i] = i;
+        for (char c : lectura) {
+          int diagonal = columna[0];
+          for (int i = 1; i <= longitudPatron; ++i) {
+            int nuevo = min({diagonal + (patron[i - 1] != c), columna[i] + 1, columna[i - 1] + 1});
+            diagonal = columna[i];
+            columna[i] = nuevo;
+          }
+          totalSellers += columna[longitudPatron] <= k;
+        }
+      }
+    });
+    vector<CoincidenciaLectura> coincidencias;
+    BuscadorAproximado buscador(patron);
+    double tMyers = medirSegundos([&] { coincidencias = buscador.buscarEnLecturas(lecturas, k); });
+    cout << setw(10) << longitudPatron << setw(6) << k << setw(14) << tSellers << setw(14) << tMyers << setw(14)
+         << tMyers * 1e9 / ((double)numLecturas * LONGITUD_LECTURA) << setw(14) << coincidencias.size() << endl;
+    if (coincidencias.size() != totalSellers)
+      cerr << "Error: Myers y Sellers no coinciden" << endl;
+  }
+}
+
+// Benchmark: score sin gaps de varias consultas contra una base de lecturas, caracter por caracter y
+// empaquetado a 2 bits con cada variante de popcount que soporte la CPU
+void benchmarkHamming(int numLecturas) {
+  const int CONSULTAS = 10;
+  mt19937 generador(17);
+  vector<string> lecturas;
+  BaseEmpaquetada base;
+  for (int r = 0; r < numLecturas; ++r) {
+    string lectura = generarSecuenciaAleatoria(100 + generador() % 101, generador);
+    if (r % 100 == 0)
+      lectura[generador() % lectura.length()] = 'N'; // unas pocas lecturas van por la ruta escalar
+    lecturas.push_back(lectura);
+  }
+  double tEmpaquetar = medirSegundos([&] {
+    for (const auto &lectura : lecturas)
+      base.agregar(lectura);
+  });
+  vector<SecuenciaEmpaquetada> consultas;
+  for (int q = 0; q < CONSULTAS; ++q)
+    consultas.emplace_back(generarSecuenciaAleatoria(150, generador));
+  cout << "--- Benchmark score sin gaps (" << CONSULTAS << " consultas x " << numLecturas << " lecturas) ---" << endl;
+  cout << "empaquetar: " << tEmpaquetar << " s, " << base.bytes() / 1e6 << " MB" << endl;
+
+  vector<int> referencia((size_t)CONSULTAS * numLecturas);
+  double tEscalar = medirSegundos([&] {
+    for (int q = 0; q < CONSULTAS; ++q) {
+      string consulta = consultas[q].cadena();
+      for (int r = 0; r < numLecturas; ++r)
+        referencia[(size_t)q * numLecturas + r] = calcularScoreSimple(consulta, lecturas[r]);
+    }
+  });
+  cout << setw(12) << "variante" << setw(12) << "segundos" << setw(14) << "ns/lectura" << endl;
+  cout << setw(12) << "caracteres" << setw(12) << tEscalar << setw(14) << tEscalar * 1e9 / CONSULTAS / numLecturas
+       << endl;
+
+  struct Variante {
+    const char *nombre;
+    bool disponible;
+    FuncionSustituciones funcion;
+  };
+  for (const Variante &v : {Variante{"popcount", true, sustitucionesEscalar},
+                            Variante{"popcnt", (bool)__builtin_cpu_supports("popcnt"), sustitucionesPopcnt},
+                            Variante{"avx2", (bool)__builtin_cpu_supports("avx2"), sustitucionesAVX2},
+                            Variante{"avx512", (bool)__builtin_cpu_supports("avx512vpopcntdq"), sustitucionesAVX512}}) {
+    if (!v.disponible)
+      continue;
+    vector<int> scores;
+    bool iguales = true;
+    double t = medirSegundos([&] {
+      for (int q = 0; q < CONSULTAS; ++q) {
+        base.calcularScores(consultas[q], scores, v.funcion);
+        iguales = iguales && equal(scores.begin(), scores.end(), referencia.begin() + (size_t)q * numLecturas);
+      }
+    });
+    cout << setw(12) << v.nombre << setw(12) << t << setw(14) << t * 1e9 / CONSULTAS / numLecturas
+         << (v.funcion == funcionSustituciones() ? "  (en uso)" : "") << endl;
+    if (!iguales)
+      cerr << "Error: la variante " << v.nombre << " no coincide con calcularScoreSimple" << endl;
+  }
+}
+
+// Llenado del alineamiento global en paralelo por teselas de tamTesela x tamTesela.
+// Cada tesela solo lee el borde inferior de la tesela de arriba y el borde derecho de la de la izquierda,
+// por lo que entre hilos solo se intercambian bordes. Si se pide, marca el traceback compacto (las teselas
+// se alinean a palabras completas para que dos hilos nunca escriban la misma) y copia las filas a matriz.
+int llenarGlobalParalelo(const string &s1, const string &s2, int numHilos, int tamTesela,
+                         MatrizTraceback *traceback = nullptr, MatrizScores *matriz = nullptr) {
+  int n = s1.length();
+  int m = s2.length();
+  if (matriz) {
+    matriz->redimensionar(n + 1, m + 1);
+    for (int i = 0; i <= n; ++i)
+      (*matriz)(i, 0) = i * GAP;
+    for (int j = 0; j <= m; ++j)
+      (*matriz)(0, j) = j * GAP;
+  }
+  if (n == 0 || m == 0)
+    return (n + m) * GAP;
+  if (traceback) {
+    const int celdas = MatrizTraceback::CELDAS_POR_PALABRA;
+    tamTesela = (tamTesela + celdas - 1) / celdas * celdas;
+  }
+
+  int filasT = (n + tamTesela - 1) / tamTesela;
+  int colsT = (m + tamTesela - 1) / tamTesela;
+  // bordeInferior[tj] = H[ultima fila llenada][columnas de tj]; bordeDerecho[ti] = H[r0-1..r1][ultima columna llenada]
+  vector<vector<int>> bordeInferior(colsT), bordeDerecho(filasT);
+  for (int tj = 0; tj < colsT; ++tj) {
+    for (int j = tj * tamTesela + 1; j <= min(m, (tj + 1) * tamTesela); ++j)
+      bordeInferior[tj].push_back(j * GAP);
+  }
+  for (int ti = 0; ti < filasT; ++ti) {
+    for (int i = ti * tamTesela; i <= min(n, (ti + 1) * tamTesela); ++i)
+      bordeDerecho[ti].push_back(i * GAP);
+  }
+
+  PoolHilos pool(numHilos);
+  recorrerTeselas(pool, filasT, colsT, [&](int ti, int tj) {
+    int r0 = ti * tamTesela + 1, r1 = min(n, (ti + 1) * tamTesela);
+    int c0 = tj * tamTesela + 1, c1 = min(m, (tj + 1) * tamTesela);
+    int ancho = c1 - c0 + 1;
+    const vector<int> &arriba = bordeInferior[tj];
+    vector<int> izquierda = bordeDerecho[ti];
+    vector<int> anterior(ancho + 1), actual(ancho + 1), derecha(r1 - r0 + 2);
+
+    anterior[0] = izquierda[0];
+    copy(arriba.begin(), arriba.end(), anterior.begin() + 1);
+    derecha[0] = anterior[ancho];
+    for (int i = r0; i <= r1; ++i) {
+      actual[0] = izquierda[i - r0 + 1];
+      for (int c = 1; c <= ancho; ++c) {
+        int j = c0 + c - 1;
+        int scoreDiagonal = anterior[c - 1] + (s1[i - 1] == s2[j - 1] ? MATCH : MISMATCH);
+        int scoreArriba = anterior[c] + GAP;
+        int scoreIzquierda = actual[c - 1] + GAP;
+        actual[c] = max({scoreDiagonal, scoreArriba, scoreIzquierda});
+        if (traceback)
+          traceback->marcar(i, j, direccionesOptimas(scoreDiagonal, scoreArriba, scoreIzquierda, actual[c]));
+      }
+      if (matriz)
+        copy(actual.begin() + 1, actual.end(), matriz->fila(i) + c0);
+      derecha[i - r0 + 1] = actual[ancho];
+      swap(anterior, actual);
+    }
+    bordeInferior[tj].assign(anterior.begin() + 1, anterior.end());
+    bordeDerecho[ti] = derecha;
+  });
+  return bordeInferior[colsT - 1].back();
+}
+
+// Score del alineamiento global con llenado paralelo; memoria O(n + m)
+int alineamientoGlobalScoreParalelo(const string &s1, const string &s2, int numHilos, int tamTesela = 256) {
+  return llenarGlobalParalelo(s1, s2, numHilos, tamTesela);
+}
+
+// Alineamiento global con llenado paralelo; el resultado es identico al de alineamientoGlobal
+ResultadoAlineamiento alineamientoGlobalParalelo(const string &s1, const string &s2, int numHilos,
+                                                 int tamTesela = 256, bool guardarMatriz = false,
+                                                 size_t maxAlineamientos = 1000) {
+  ResultadoAlineamiento resultado;
+  MatrizTraceback traceback(s1.length(), s2.length());
+  resultado.scoreFinal = llenarGlobalParalelo(s1, s2, numHilos, tamTesela, &traceback,
+                                              guardarMatriz ? &resultado.matrizScores : nullptr);
+  ConteoAlineamientos conteo = contarAlineamientosOptimos(traceback, s1.length(), s2.length());
+  resultado.cantidadAlineamientos = conteo.cantidad;
+  resultado.cantidadSaturada = conteo.saturado;
+  resultado.alineamientosGenerados = primerosAlineamientos(s1, s2, traceback, maxAlineamientos);
+  return resultado;
+}
+
+// Benchmark: escalamiento del llenado por teselas (solo score y matriz para traceback) hasta 32 hilos
+void benchmarkHilos(int longitud) {
+  mt19937 generador(7);
+  string s1 = generarSecuenciaAleatoria(longitud, generador);
+  string s2 = mutarSecuencia(s1, 0.1, generador);
+  int scoreSerial = alineamientoGlobalScoreDelta(s1, s2);
+  cout << "--- Benchmark hilos (longitud " << longitud << ", " << thread::hardware_concurrency()
+       << " nucleos) ---" << endl;
+  cout << setw(8) << "hilos" << setw(14) << "solo score" << setw(14) << "traceback" << endl;
+  for (int hilos : {1, 2, 4, 8, 16, 32}) {
+    int score = 0, scoreMatriz = 0;
+    double tScore = medirSegundos([&] { score = alineamientoGlobalScoreParalelo(s1, s2, hilos); });
+    double tMatriz = medirSegundos([&] {
+      MatrizTraceback traceback(s1.length(), s2.length());
+      scoreMatriz = llenarGlobalParalelo(s1, s2, hilos, 256, &traceback);
+    });
+    if (score != scoreSerial || scoreMatriz != scoreSerial) {
+      cerr << "Error: el llenado paralelo no coincide con el serial" << endl;
+    }
+    cout << setw(8) << hilos << setw(14) << tScore << setw(14) << tMatriz << endl;
+  }
+}
+
+// Función para guardar resultados; cada CIGAR se expande a las cadenas con gaps de siempre
+void guardarResultados(const string &nombreArchivo, const ResultadoAlineamiento &resultado, const string &s1,
+                       const string &s2, const OpcionesMatriz &opcionesMatriz = OpcionesMatriz()) {
+  Rectangulo rectangulo = {0, 0, resultado.matrizScores.filas(), resultado.matrizScores.columnas()};
+  if (opcionesMatriz.margenCamino >= 0 && !resultado.alineamientosGenerados.empty()) {
+    rectangulo = rectanguloCamino(resultado.alineamientosGenerados[0], 0, 0, opcionesMatriz.margenCamino,
+                                  resultado.matrizScores);
+  }
+  if (!opcionesMatriz.archivoNpy.empty() && !resultado.matrizScores.vacia() &&
+      exportarMatrizNpy(opcionesMatriz.archivoNpy, resultado.matrizScores, rectangulo)) {
+    cout << "Matriz guardada en " << opcionesMatriz.archivoNpy << endl;
+  }
+
   ofstream archivoSalida(nombreArchivo);
   if (archivoSalida.is_open()) {
     archivoSalida << "* Score final(Optimo): " << resultado.scoreFinal << endl;
-    archivoSalida << "\n* Matriz:" << endl;
-    for (const auto &fila : resultado.matrizScores) {
-      for (size_t j = 0; j < fila.size(); ++j) {
-        archivoSalida << setw(4) << fila[j] << (j == fila.size() - 1 ? "" : "\t");
+    if (opcionesMatriz.texto) {
+      archivoSalida << "\n* Matriz:" << endl;
+      for (int i = rectangulo.fila; i < rectangulo.fila + rectangulo.filas; ++i) {
+        for (int j = rectangulo.columna; j < rectangulo.columna + rectangulo.columnas; ++j) {
+          archivoSalida << setw(4) << resultado.matrizScores(i, j)
+                        << (j == rectangulo.columna + rectangulo.columnas - 1 ? "" : "\t");
+        }
+        archivoSalida << endl;
       }
-      archivoSalida << endl;
     }
 
-    archivoSalida << "\n* N de alineamientos optimos: " << resultado.cantidadAlineamientos << endl;
-    archivoSalida << "\n* Alineamientos optimos:" << endl;
+    archivoSalida << "\n* N de alineamientos optimos: " << (resultado.cantidadSaturada ? ">= " : "")
+                  << resultado.cantidadAlineamientos << endl;
+    if (resultado.alineamientosGenerados.size() < resultado.cantidadAlineamientos) {
+      archivoSalida << "\n* Alineamientos optimos (primeros " << resultado.alineamientosGenerados.size()
+                    << "):" << endl;
+    } else {
+      archivoSalida << "\n* Alineamientos optimos:" << endl;
+    }
     for (size_t i = 0; i < resultado.alineamientosGenerados.size(); ++i) {
       archivoSalida << "\t*Alineamiento " << i + 1 << ":" << endl;
-      archivoSalida << "\t\t" << resultado.alineamientosGenerados[i].first << endl;
-      archivoSalida << "\t\t" << resultado.alineamientosGenerados[i].second << endl << endl;
+      pair<string, string> columnas = resultado.alineamientosGenerados[i].expandir(s1, s2);
+      archivoSalida << "\t\t" << columnas.first << endl;
+      archivoSalida << "\t\t" << columnas.second << endl << endl;
     }
 
     archivoSalida.close();
@@ -162,7 +1982,334 @@ void guardarResultados(const string &nombreArchivo, const ResultadoAlineamiento
   }
 }
 
-int main() {
+// ===================================== Pruebas (./main test) =====================================
+// Cada kernel contra una implementacion directa de fuerza bruta, con entradas aleatorias de semilla fija
+// y los bordes: secuencias vacias, de un caracter y patrones de mas de 64 bases (mas de una palabra).
+
+// Secuencia al azar sobre un alfabeto dado; los alfabetos chicos dan muchas repeticiones y empates
+static string secuenciaPrueba(int longitud, const string &alfabeto, mt19937 &generador) {
+  string sec(longitud, alfabeto[0]);
+  for (char &c : sec)
+    c = alfabeto[generador() % alfabeto.size()];
+  return sec;
+}
+
+// Todas las ocurrencias exactas comparando el patron en cada posicion del texto
+static vector<size_t> ocurrenciasIngenuas(const string &texto, const string &patron) {
+  vector<size_t> posiciones;
+  for (size_t i = 0; i + patron.length() <= texto.length(); ++i)
+    if (texto.compare(i, patron.length(), patron) == 0)
+      posiciones.push_back(i);
+  return posiciones;
+}
+
+// Patrones para buscar en un texto: vacio, un caracter fuera del alfabeto, subcadenas del texto (que
+// aparecen seguro) y cadenas al azar (que casi nunca aparecen), de 1 a 150 caracteres
+static vector<string> patronesPrueba(const string &texto, const string &alfabeto, mt19937 &generador) {
+  vector<string> patrones = {"", "#"};
+  for (int longitud : {1, 2, 5, 20, 64, 65, 100, 150}) {
+    if (longitud <= (int)texto.length())
+      patrones.push_back(texto.substr(generador() % (texto.length() - longitud + 1), longitud));
+    patrones.push_back(secuenciaPrueba(longitud, alfabeto, generador));
+  }
+  return patrones;
+}
+
+// Needleman-Wunsch con la matriz completa de scores
+template <class P> static int scoreGlobalDirecto(const string &s1, const string &s2) {
+  int n = s1.length(), m = s2.length();
+  vector<vector<int>> H(n + 1, vector<int>(m + 1));
+  for (int i = 0; i <= n; ++i)
+    H[i][0] = i * P::extension;
+  for (int j = 0; j <= m; ++j)
+    H[0][j] = j * P::extension;
+  for (int i = 1; i <= n; ++i)
+    for (int j = 1; j <= m; ++j)
+      H[i][j] = max({H[i - 1][j - 1] + P::sustitucion(s1[i - 1], s2[j - 1]), H[i - 1][j] + P::extension,
+                     H[i][j - 1] + P::extension});
+  return H[n][m];
+}
+
+// Gotoh con las tres matrices completas: H (cualquier final), E (termina con gap en s2), F (gap en s1)
+template <class P> static int scoreGlobalAfinDirecto(const string &s1, const string &s2) {
+  int n = s1.length(), m = s2.length();
+  vector<vector<int>> H(n + 1, vector<int>(m + 1)), E = H, F = H;
+  E[0][0] = F[0][0] = MENOS_INFINITO;
+  for (int i = 1; i <= n; ++i) {
+    H[i][0] = E[i][0] = P::apertura + i * P::extension;
+    F[i][0] = MENOS_INFINITO;
+  }
+  for (int j = 1; j <= m; ++j) {
+    H[0][j] = F[0][j] = P::apertura + j * P::extension;
+    E[0][j] = MENOS_INFINITO;
+  }
+  for (int i = 1; i <= n; ++i)
+    for (int j = 1; j <= m; ++j) {
+      E[i][j] = max(E[i - 1][j], H[i - 1][j] + P::apertura) + P::extension;
+      F[i][j] = max(F[i][j - 1], H[i][j - 1] + P::apertura) + P::extension;
+      H[i][j] = max({H[i - 1][j - 1] + P::sustitucion(s1[i - 1], s2[j - 1]), E[i][j], F[i][j]});
+    }
+  return H[n][m];
+}
+
+// El cigar recorre s1 y s2 completas y sus '=' y 'X' dicen la verdad sobre cada columna
+static bool cigarConsistente(const Cigar &cigar, const string &s1, const string &s2) {
+  size_t i = 0, j = 0;
+  for (size_t k = 0; k < cigar.cantidadRachas(); ++k) {
+    char op = cigar.operacion(k);
+    for (uint32_t c = 0; c < cigar.longitud(k); ++c) {
+      if (op != 'I' && i >= s1.length())
+        return false;
+      if (op != 'D' && j >= s2.length())
+        return false;
+      if ((op == '=' && s1[i] != s2[j]) || (op == 'X' && s1[i] == s2[j]))
+        return false;
+      i += op != 'I';
+      j += op != 'D';
+    }
+  }
+  return i == s1.length() && j == s2.length();
+}
+
+// Pares para los alineamientos globales: bordes fijos y pares al azar parecidos o sin relacion
+static vector<pair<string, string>> paresPrueba(mt19937 &generador) {
+  vector<pair<string, string>> pares = {{"", ""}, {"", "ACGT"}, {"GATTACA", ""}, {"A", "A"}, {"A", "C"},
+                                        {"A", generarSecuenciaAleatoria(100, generador)}};
+  for (int longitud : {2, 15, 64, 65, 150, 300})
+    for (double divergencia : {0.0, 0.05, 0.3}) {
+      string base = generarSecuenciaAleatoria(longitud, generador);
+      pares.push_back({base, mutarSecuencia(base, divergencia, generador)});
+    }
+  for (int k = 0; k < 10; ++k)
+    pares.push_back({generarSecuenciaAleatoria(generador() % 200, generador),
+                     generarSecuenciaAleatoria(generador() % 200, generador)});
+  return pares;
+}
+
+TEST_CASE("Índice FM (SA-IS) contra búsqueda ingenua") {
+  mt19937 generador(101);
+
+  SUBCASE("Conteo y posiciones en referencias al azar") {
+    for (string alfabeto : {"A", "AC", "ACGT", "ACDEFGHIKLMNPQRSTVWY"})
+      for (int longitud : {0, 1, 2, 63, 64, 65, 300, 2000}) {
+        string referencia = secuenciaPrueba(longitud, alfabeto, generador);
+        IndiceFM indice;
+        REQUIRE(indice.construir(referencia, 1 + generador() % 40));
+        for (const string &patron : patronesPrueba(referencia, alfabeto, generador)) {
+          vector<size_t> esperadas = ocurrenciasIngenuas(referencia, patron);
+          CHECK(indice.contar(patron) == esperadas.size());
+          CHECK(indice.localizar(patron) == esperadas);
+        }
+      }
+  }
+
+  // El indice proyectado del archivo responde igual que el construido en memoria
+  SUBCASE("Guardar y abrir") {
+    string referencia = generarSecuenciaAleatoria(5000, generador);
+    const string archivo = "prueba_indice_fm.bin";
+    IndiceFM construido, proyectado;
+    REQUIRE(construido.construir(referencia, 16));
+    REQUIRE(construido.guardar(archivo));
+    REQUIRE(proyectado.abrir(archivo));
+    for (const string &patron : patronesPrueba(referencia, "ACGT", generador))
+      CHECK(proyectado.localizar(patron) == ocurrenciasIngenuas(referencia, patron));
+    remove(archivo.c_str());
+  }
+
+  SUBCASE("Demasiados caracteres distintos") {
+    string referencia;
+    for (int c = 1; c < 256; ++c)
+      referencia += (char)c;
+    IndiceFM indice;
+    CHECK_FALSE(indice.construir(referencia));
+  }
+}
+
+TEST_CASE("Two-Way y Aho-Corasick contra búsqueda ingenua") {
+  mt19937 generador(102);
+  for (string alfabeto : {"A", "AC", "ACGT"})
+    for (int longitud : {0, 1, 64, 65, 500}) {
+      string texto = secuenciaPrueba(longitud, alfabeto, generador);
+      vector<string> patrones = patronesPrueba(texto, alfabeto, generador);
+      vector<pair<int, size_t>> esperadas, encontradas;
+      for (size_t p = 0; p < patrones.size(); ++p) {
+        vector<size_t> posiciones = ocurrenciasIngenuas(texto, patrones[p]);
+        CHECK(BuscadorTwoWay(patrones[p]).buscar(texto) == posiciones);
+        for (size_t posicion : posiciones)
+          esperadas.push_back({(int)p, posicion});
+      }
+      // Aho-Corasick reporta en el orden en que termina cada ocurrencia
+      for (const Ocurrencia &o : AutomataAhoCorasick(patrones).buscar(texto))
+        encontradas.push_back({o.patron, o.posicion});
+      sort(esperadas.begin(), esperadas.end());
+      sort(encontradas.begin(), encontradas.end());
+      CHECK(encontradas == esperadas);
+    }
+}
+
+// Sellers: la misma matriz de edicion que Myers/Hyyro, columna por columna con enteros
+static vector<pair<size_t, int>> coincidenciasAproximadasDirecto(const string &texto, const string &patron,
+                                                                 int maxDiferencias) {
+  int m = patron.length();
+  vector<int> columna(m + 1), nueva(m + 1);
+  for (int i = 0; i <= m; ++i)
+    columna[i] = i;
+  vector<pair<size_t, int>> coincidencias;
+  for (size_t j = 0; j < texto.length(); ++j) {
+    nueva[0] = 0;
+    for (int i = 1; i <= m; ++i)
+      nueva[i] = min({columna[i - 1] + (patron[i - 1] != texto[j]), columna[i] + 1, nueva[i - 1] + 1});
+    swap(columna, nueva);
+    if (columna[m] <= maxDiferencias)
+      coincidencias.push_back({j, columna[m]});
+  }
+  return coincidencias;
+}
+
+TEST_CASE("Myers/Hyyrö contra la matriz de edición") {
+  mt19937 generador(103);
+  for (int longitudPatron : {0, 1, 2, 31, 63, 64, 65, 127, 128, 129, 200}) {
+    string patron = generarSecuenciaAleatoria(longitudPatron, generador);
+    BuscadorAproximado buscador(patron);
+    CHECK(buscador.buscar("", 3).empty());
+    for (int maxDiferencias : {0, 1, 3, 10, 40}) {
+      // Copias exacta y mutada del patron entre relleno al azar, para que haya coincidencias cercanas
+      string texto = generarSecuenciaAleatoria(200, generador) + mutarSecuencia(patron, 0.05, generador) +
+                     generarSecuenciaAleatoria(100, generador) + patron + generarSecuenciaAleatoria(50, generador);
+      vector<pair<size_t, int>> encontradas;
+      for (const CoincidenciaAproximada &c : buscador.buscar(texto, maxDiferencias))
+        encontradas.push_back({c.fin, c.distancia});
+      CHECK(encontradas == coincidenciasAproximadasDirecto(texto, patron, maxDiferencias));
+    }
+  }
+}
+
+TEST_CASE("Gotoh en espacio lineal (Hirschberg) contra las tres matrices completas") {
+  mt19937 generador(104);
+  for (const pair<string, string> &par : paresPrueba(generador)) {
+    const string &s1 = par.first, &s2 = par.second;
+    int esperado = scoreGlobalAfinDirecto<PuntuacionBlastn>(s1, s2);
+    CHECK(alineamientoGlobalScore<PuntuacionBlastn>(s1, s2) == esperado);
+    ResultadoAlineamiento resultado = alineamientoGlobalAfin<PuntuacionBlastn>(s1, s2);
+    CHECK(resultado.scoreFinal == esperado);
+    REQUIRE(resultado.alineamientosGenerados.size() == 1);
+    const Cigar &cigar = resultado.alineamientosGenerados[0];
+    CHECK(cigarConsistente(cigar, s1, s2));
+    CHECK(puntuarCigar<PuntuacionBlastn>(cigar, s1, s2) == esperado);
+  }
+}
+
+TEST_CASE("Diferencias, banda, WFA y teselas contra Needleman-Wunsch directo") {
+  mt19937 generador(105);
+  for (const pair<string, string> &par : paresPrueba(generador)) {
+    const string &s1 = par.first, &s2 = par.second;
+    int esperado = scoreGlobalDirecto<PuntuacionEstandar>(s1, s2);
+    CHECK(alineamientoGlobalScoreDelta(s1, s2) == esperado);
+    CHECK(alineamientoGlobalScore(s1, s2, EsquemaPuntuacion::Transiciones) ==
+          scoreGlobalDirecto<PuntuacionTransiciones>(s1, s2));
+    CHECK(alineamientoGlobalScoreParalelo(s1, s2, 3, 32) == esperado);
+
+    ResultadoAlineamiento completo = alineamientoGlobal(s1, s2, false, 5);
+    CHECK(completo.scoreFinal == esperado);
+    for (const Cigar &cigar : completo.alineamientosGenerados) {
+      CHECK(cigarConsistente(cigar, s1, s2));
+      CHECK(puntuarCigar<PuntuacionEstandar>(cigar, s1, s2) == esperado);
+    }
+
+    ResultadoWFA wfa = alineamientoGlobalWFA(s1, s2);
+    CHECK(wfa.scoreFinal == esperado);
+    CHECK(cigarConsistente(wfa.alineamiento, s1, s2));
+    CHECK(puntuarCigar<PuntuacionEstandar>(wfa.alineamiento, s1, s2) == esperado);
+
+    // Banda inicial angosta: debe ensancharse hasta demostrar el optimo
+    ResultadoBanda banda = alineamientoGlobalBanda(s1, s2, 2, -1, true);
+    CHECK(banda.optimo);
+    CHECK(banda.scoreFinal == esperado);
+    CHECK(cigarConsistente(banda.alineamiento, s1, s2));
+    CHECK(puntuarCigar<PuntuacionEstandar>(banda.alineamiento, s1, s2) == esperado);
+  }
+}
+
+TEST_CASE("Score sin gaps empaquetado contra calcularScoreSimple") {
+  mt19937 generador(106);
+  vector<string> lecturas = {"", "A", "N"};
+  for (int longitud : {1, 31, 32, 33, 63, 64, 65, 100, 257}) {
+    string lectura = generarSecuenciaAleatoria(longitud, generador);
+    lecturas.push_back(lectura);
+    lectura[generador() % longitud] = 'N';
+    lecturas.push_back(lectura);
+  }
+  // Una lectura vacia al final: su inicio queda en el fin del arreglo de palabras
+  lecturas.push_back("");
+  BaseEmpaquetada base;
+  for (const string &lectura : lecturas)
+    base.agregar(lectura);
+  for (size_t k = 0; k < lecturas.size(); ++k)
+    CHECK(base.cadena(k) == lecturas[k]);
+
+  vector<string> consultas = {"", "A", "ACGTN"};
+  for (int longitud : {1, 32, 64, 65, 150, 300})
+    consultas.push_back(generarSecuenciaAleatoria(longitud, generador));
+  vector<FuncionSustituciones> variantes = {sustitucionesEscalar};
+  if (__builtin_cpu_supports("popcnt"))
+    variantes.push_back(sustitucionesPopcnt);
+  if (__builtin_cpu_supports("avx2"))
+    variantes.push_back(sustitucionesAVX2);
+  if (__builtin_cpu_supports("avx512vpopcntdq"))
+    variantes.push_back(sustitucionesAVX512);
+  for (const string &consulta : consultas) {
+    SecuenciaEmpaquetada empaquetada(consulta);
+    for (FuncionSustituciones variante : variantes) {
+      vector<int> scores;
+      base.calcularScores(empaquetada, scores, variante);
+      for (size_t k = 0; k < lecturas.size(); ++k)
+        CHECK(scores[k] == calcularScoreSimple(consulta, lecturas[k]));
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // ./main test [opciones de doctest]: pruebas de los kernels contra implementaciones directas
+  if (argc > 1 && string(argv[1]) == "test") {
+    doctest::Context contexto(argc - 1, argv + 1);
+    return contexto.run();
+  }
+  // ./main simd: que variante de cada kernel se eligio (BIOINF_SIMD=escalar|avx2|avx512 la fuerza)
+  if (argc > 1 && string(argv[1]) == "simd") {
+    imprimirDespachoSIMD();
+    return 0;
+  }
+  // Modo benchmark: ./main bench-wfa [longitud]
+  if (argc > 1 && string(argv[1]) == "bench-wfa") {
+    benchmarkWFA(argc > 2 ? stoi(argv[2]) : 10000);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-busqueda [lecturas]
+  if (argc > 1 && string(argv[1]) == "bench-busqueda") {
+    benchmarkBusqueda(argc > 2 ? stoi(argv[2]) : 5000);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-fm [megabases]
+  if (argc > 1 && string(argv[1]) == "bench-fm") {
+    benchmarkFM(argc > 2 ? stoi(argv[2]) : 10);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-aproximada [lecturas]
+  if (argc > 1 && string(argv[1]) == "bench-aproximada") {
+    benchmarkAproximada(argc > 2 ? stoi(argv[2]) : 100000);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-hamming [lecturas]
+  if (argc > 1 && string(argv[1]) == "bench-hamming") {
+    benchmarkHamming(argc > 2 ? stoi(argv[2]) : 1000000);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-hilos [longitud]
+  if (argc > 1 && string(argv[1]) == "bench-hilos") {
+    benchmarkHilos(argc > 2 ? stoi(argv[2]) : 20000);
+    return 0;
+  }
+
   // Cadenas con diferentes tamaños (larga, mediana y corta)
   string secA = "GCTAGGCGATCGGCTAAGGCTAGTACGATGCA";
   string secB = "CGATCGGCTAAGGCTAGT";
@@ -186,25 +2333,29 @@ int main() {
   cout << "Score entre '" << secB << "' y '" << secC << "': " << calcularScoreSimple(secB, secC) << endl;
   cout << endl;
 
-  // 3. Alineamiento Global
+  // 3. Alineamiento Global (la matriz se escribe en texto dentro de cada archivo de resultados)
   cout << "--- Alineamiento Global ---" << endl;
+  OpcionesMatriz matrizEnTexto;
+  matrizEnTexto.texto = true;
   string sec1 = "GATTACA";
   string sec2 = "GCATGCU";
   cout << "\nAlineando '" << sec1 << "' y '" << sec2 << "'" << endl;
-  ResultadoAlineamiento resAG = alineamientoGlobal(sec1, sec2);
-  guardarResultados("alineamiento_global_1.txt", resAG);
+  ResultadoAlineamiento resAG = alineamientoGlobal(sec1, sec2, true);
+  OpcionesMatriz matrizTextoYNpy = matrizEnTexto;
+  matrizTextoYNpy.archivoNpy = "alineamiento_global_1_matriz.npy";
+  guardarResultados("alineamiento_global_1.txt", resAG, sec1, sec2, matrizTextoYNpy);
 
   string sec3 = "ATGCGTACG";
   string sec4 = "GCTAGC";
   cout << "\nAlineando '" << sec3 << "' y '" << sec4 << "'" << endl;
-  ResultadoAlineamiento resAG2 = alineamientoGlobal(sec3, sec4);
-  guardarResultados("alineamiento_global_2.txt", resAG2);
+  ResultadoAlineamiento resAG2 = alineamientoGlobal(sec3, sec4, true);
+  guardarResultados("alineamiento_global_2.txt", resAG2, sec3, sec4, matrizEnTexto);
 
   string sec5 = "CGTAGCTAGCTACGAT";
   string sec6 = "AGCTGACTG";
   cout << "\nAlineando '" << sec5 << "' y '" << sec6 << "'" << endl;
-  ResultadoAlineamiento resAG3 = alineamientoGlobal(sec5, sec6);
-  guardarResultados("alineamiento_global_3.txt", resAG3);
+  ResultadoAlineamiento resAG3 = alineamientoGlobal(sec5, sec6, true);
+  guardarResultados("alineamiento_global_3.txt", resAG3, sec5, sec6, matrizEnTexto);
 
   return 0;
 }
@@ -1,21 +1,35 @@
+#define DOCTEST_CONFIG_IMPLEMENT
+#include "../lab01/doctest.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
+#include <functional>
+#include <immintrin.h>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
-using namespace std;
+#include "../comun/alineamiento.h"
 
-// Parámetros para el alineamiento
-const int MATCH = 1;
-const int MISMATCH = -1;
-const int GAP = -2;
+using namespace std;
 
 // Estructura para almacenar la información detallada de un alineamiento local
 struct AlineamientoInfo {
-  string s1_alineada;
-  string s2_alineada;
+  Cigar cigar; // s1[start_s1..end_s1] frente a s2[start_s2..end_s2]
   int start_s1;
   int end_s1;
   int start_s2;
@@ -25,127 +39,1712 @@ struct AlineamientoInfo {
 // Estructura para los resultados del alineamiento local
 struct ResultadoAlineamientoLocal {
   int scoreMayor;
-  vector<vector<int>> matrizScores;
+  MatrizScores matrizScores;
   vector<AlineamientoInfo> alineamientos;
 };
 
-// Función para reconstruir un alineamiento local
-void reconstruir(const string &s1, const string &s2, const vector<vector<int>> &matriz, int end_row, int end_col,
-                 vector<AlineamientoInfo> &todosLosAlineamientos) {
+// Mejor celda de un alineamiento local: score y coordenadas (fila, columna) en la matriz.
+// Entre empates se toma la primera en orden de filas, igual que alineamientoLocal.
+struct MejorCeldaLocal {
+  int score;
+  int fila;
+  int columna;
+};
+
+static bool mejorQue(const MejorCeldaLocal &a, const MejorCeldaLocal &b) {
+  if (a.score != b.score)
+    return a.score > b.score;
+  return a.fila != b.fila ? a.fila < b.fila : a.columna < b.columna;
+}
+
+// Direcciones que alcanzan el maximo de una celda; una celda con score 0 no tiene predecesor
+static inline uint8_t direccionesOptimas(int scoreDiagonal, int scoreArriba, int scoreIzquierda, int mejor) {
+  if (mejor == 0)
+    return 0;
+  return (scoreDiagonal == mejor ? MatrizTraceback::DIAGONAL : 0) |
+         (scoreArriba == mejor ? MatrizTraceback::ARRIBA : 0) |
+         (scoreIzquierda == mejor ? MatrizTraceback::IZQUIERDA : 0);
+}
 
-  if (end_row == 0 || end_col == 0 || matriz[end_row][end_col] == 0) {
+// Coordenadas (inicio, fin) de un alineamiento ya reportado: (start_s1 << 32 | start_s2, end_s1 << 32 | end_s2)
+struct HashExtremos {
+  size_t operator()(const pair<uint64_t, uint64_t> &extremos) const {
+    return hash<uint64_t>()(extremos.first * 0x9E3779B97F4A7C15ULL ^ extremos.second);
+  }
+};
+using ExtremosAlineamientos = unordered_set<pair<uint64_t, uint64_t>, HashExtremos>;
+
+// Función para reconstruir un alineamiento local. El traceback es determinista, asi que el camino queda
+// fijado por sus extremos: un empate solo se descarta si ya se reporto uno con el mismo inicio y el mismo
+// fin (el mismo camino); empates con otra celda final se reportan aunque compartan el inicio.
+void reconstruir(const string &s1, const string &s2, const MatrizTraceback &traceback, int end_row, int end_col,
+                 vector<AlineamientoInfo> &todosLosAlineamientos, ExtremosAlineamientos &reportados) {
+
+  if (traceback.direcciones(end_row, end_col) == 0) {
     return;
   }
 
-  string alin1_rev, alin2_rev;
+  Cigar cigar;
   int i = end_row;
   int j = end_col;
 
   // Reconstruir el alineamiento hacia atrás
-  while (i > 0 && j > 0 && matriz[i][j] != 0) {
-    int scoreActual = matriz[i][j];
+  uint8_t direcciones;
+  while ((direcciones = traceback.direcciones(i, j)) != 0) {
     // El carácter actual de s1 es s1[i-1], de s2 es s2[j-1]
-    int scoreDiagonal = (s1[i - 1] == s2[j - 1] ? MATCH : MISMATCH);
-
-    if (scoreActual == matriz[i - 1][j - 1] + scoreDiagonal) {
-      alin1_rev += s1[i - 1];
-      alin2_rev += s2[j - 1];
+    if (direcciones & MatrizTraceback::DIAGONAL) {
+      cigar.agregarPar(s1[i - 1], s2[j - 1]);
       i--;
       j--;
-    } else if (scoreActual == matriz[i - 1][j] + GAP) {
-      alin1_rev += s1[i - 1];
-      alin2_rev += '-';
+    } else if (direcciones & MatrizTraceback::ARRIBA) {
+      cigar.agregar('D');
       i--;
-    } else if (scoreActual == matriz[i][j - 1] + GAP) {
-      alin1_rev += '-';
-      alin2_rev += s2[j - 1];
-      j--;
     } else {
-      break;
+      cigar.agregar('I');
+      j--;
     }
   }
 
   AlineamientoInfo info;
-  reverse(alin1_rev.begin(), alin1_rev.end());
-  reverse(alin2_rev.begin(), alin2_rev.end());
-  info.s1_alineada = alin1_rev;
-  info.s2_alineada = alin2_rev;
+  cigar.invertir();
+  info.cigar = cigar;
 
   info.end_s1 = end_row - 1;
   info.end_s2 = end_col - 1;
   info.start_s1 = i;
   info.start_s2 = j;
 
-  if (!info.s1_alineada.empty() || !info.s2_alineada.empty()) {
-    bool duplicado = false;
-    for (const auto &existente : todosLosAlineamientos) {
-      if (existente.s1_alineada == info.s1_alineada && existente.s2_alineada == info.s2_alineada &&
-          existente.start_s1 == info.start_s1 && existente.end_s1 == info.end_s1 && existente.start_s2 == info.start_s2 &&
-          existente.end_s2 == info.end_s2) {
-        duplicado = true;
-        break;
-      }
-    }
-    if (!duplicado) {
-      todosLosAlineamientos.push_back(info);
-    }
+  pair<uint64_t, uint64_t> extremos = {(uint64_t)info.start_s1 << 32 | (uint32_t)info.start_s2,
+                                       (uint64_t)info.end_s1 << 32 | (uint32_t)info.end_s2};
+  if (!info.cigar.vacio() && reportados.insert(extremos).second) {
+    todosLosAlineamientos.push_back(info);
   }
 }
 
-// Implementación del alineamiento local
-ResultadoAlineamientoLocal alineamientoLocal(const string &s1, const string &s2) {
+// Implementación del alineamiento local. Las filas de scores rotan y solo se guarda la matriz de
+// traceback compacta; la matriz completa de scores (O(n*m) enteros) se conserva solo si guardarMatriz,
+// que por defecto es false: solo la piden quienes la imprimen o la vuelcan. Se guardan a lo
+// sumo maxAlineamientos celdas empatadas en el maximo (las primeras en orden de filas): en entradas
+// repetitivas puede haber O(n*m). Si solo hace falta el score y su celda final, alineamientoLocalScore
+// es mucho mas barato (SIMD, memoria O(m)).
+// P es la politica de puntuacion; con gaps afines se usa alineamientoLocalAfin.
+template <class P> ResultadoAlineamientoLocal alineamientoLocalAfin(const string &s1, const string &s2);
+
+template <class P = PuntuacionEstandar>
+ResultadoAlineamientoLocal alineamientoLocal(const string &s1, const string &s2, bool guardarMatriz = false,
+                                             size_t maxAlineamientos = 1000) {
+  if constexpr (P::esAfin) {
+    return alineamientoLocalAfin<P>(s1, s2);
+  }
   int n = s1.length();
   int m = s2.length();
 
-  vector<vector<int>> matriz(n + 1, vector<int>(m + 1));
+  MatrizTraceback traceback(n, m, false);
+  vector<int> anterior(m + 1, 0), actual(m + 1, 0);
   int scoreMayor = 0;
   vector<pair<int, int>> celdasMaxScore; // Almacena coordenadas de celdas con scoreMayor
 
-  for (int i = 0; i <= n; ++i)
-    matriz[i][0] = 0;
-  for (int j = 0; j <= m; ++j)
-    matriz[0][j] = 0;
+  ResultadoAlineamientoLocal resultado;
+  if (guardarMatriz)
+    resultado.matrizScores.redimensionar(n + 1, m + 1);
 
   for (int i = 1; i <= n; ++i) {
     for (int j = 1; j <= m; ++j) {
-      int scoreDiagonal = matriz[i - 1][j - 1] + (s1[i - 1] == s2[j - 1] ? MATCH : MISMATCH);
-      int scoreArriba = matriz[i - 1][j] + GAP;
-      int scoreIzquierda = matriz[i][j - 1] + GAP;
-      matriz[i][j] = max({0, scoreDiagonal, scoreArriba, scoreIzquierda});
-
-      if (matriz[i][j] > scoreMayor) {
-        scoreMayor = matriz[i][j];
-        celdasMaxScore.clear();
-        celdasMaxScore.push_back({i, j});
-      } else if (matriz[i][j] == scoreMayor && scoreMayor > 0) {
+      int scoreDiagonal = anterior[j - 1] + P::sustitucion(s1[i - 1], s2[j - 1]);
+      int scoreArriba = anterior[j] + P::extension;
+      int scoreIzquierda = actual[j - 1] + P::extension;
+      actual[j] = max({0, scoreDiagonal, scoreArriba, scoreIzquierda});
+      traceback.marcar(i, j, direccionesOptimas(scoreDiagonal, scoreArriba, scoreIzquierda, actual[j]));
+
+      if (actual[j] > scoreMayor) {
+        scoreMayor = actual[j];
+        celdasMaxScore.assign(1, {i, j});
+      } else if (actual[j] == scoreMayor && scoreMayor > 0 && celdasMaxScore.size() < maxAlineamientos) {
         celdasMaxScore.push_back({i, j});
       }
     }
+    if (guardarMatriz)
+      copy(actual.begin(), actual.end(), resultado.matrizScores.fila(i));
+    swap(anterior, actual);
   }
 
-  ResultadoAlineamientoLocal resultado;
   resultado.scoreMayor = scoreMayor;
-  resultado.matrizScores = matriz;
 
   // reconstruccion con el score mayor
+  ExtremosAlineamientos reportados;
   for (const auto &celda : celdasMaxScore) {
-    reconstruir(s1, s2, matriz, celda.first, celda.second, resultado.alineamientos);
+    reconstruir(s1, s2, traceback, celda.first, celda.second, resultado.alineamientos, reportados);
+  }
+  return resultado;
+}
+
+// Alineamiento local con gaps afines en memoria lineal. La pasada de Gotoh arrastra, junto a cada score
+// de H y E, la celda donde empezo su camino; con la celda final del mejor score y su inicio, el camino
+// se recupera con Myers-Miller global dentro de ese subrectangulo (su optimo global es el local).
+// Se reporta un solo alineamiento optimo y no se guarda matriz de scores.
+template <class P> ResultadoAlineamientoLocal alineamientoLocalAfin(const string &s1, const string &s2) {
+  int n = s1.length();
+  int m = s2.length();
+  vector<int> H(m + 1, 0), E(m + 1, MENOS_INFINITO);
+  vector<pair<int, int>> inicioH(m + 1), inicioE(m + 1);
+  MejorCeldaLocal mejor = {0, 0, 0};
+  pair<int, int> inicioMejor;
+
+  for (int j = 0; j <= m; ++j)
+    inicioH[j] = {0, j};
+  for (int i = 1; i <= n; ++i) {
+    int diagonal = 0;
+    pair<int, int> inicioDiagonal = {i - 1, 0};
+    int F = MENOS_INFINITO;
+    pair<int, int> inicioF;
+    inicioH[0] = {i, 0};
+    for (int j = 1; j <= m; ++j) {
+      int scoreDiagonal = diagonal + P::sustitucion(s1[i - 1], s2[j - 1]);
+      pair<int, int> inicioScoreDiagonal = inicioDiagonal;
+      diagonal = H[j];
+      inicioDiagonal = inicioH[j];
+
+      if (H[j] + P::apertura >= E[j]) {
+        E[j] = H[j] + P::apertura + P::extension;
+        inicioE[j] = inicioH[j];
+      } else {
+        E[j] += P::extension;
+      }
+      if (H[j - 1] + P::apertura >= F) {
+        F = H[j - 1] + P::apertura + P::extension;
+        inicioF = inicioH[j - 1];
+      } else {
+        F += P::extension;
+      }
+
+      H[j] = max({0, scoreDiagonal, E[j], F});
+      if (H[j] == 0) {
+        inicioH[j] = {i, j};
+      } else if (H[j] == scoreDiagonal) {
+        inicioH[j] = inicioScoreDiagonal;
+      } else if (H[j] == E[j]) {
+        inicioH[j] = inicioE[j];
+      } else {
+        inicioH[j] = inicioF;
+      }
+
+      if (H[j] > mejor.score) {
+        mejor = {H[j], i, j};
+        inicioMejor = inicioH[j];
+      }
+    }
+  }
+
+  ResultadoAlineamientoLocal resultado;
+  resultado.scoreMayor = mejor.score;
+  if (mejor.score > 0) {
+    AlineamientoInfo info;
+    int filaIni = inicioMejor.first, colIni = inicioMejor.second;
+    hirschbergAfin<P>(s1.data() + filaIni, mejor.fila - filaIni, s2.data() + colIni, mejor.columna - colIni,
+                      P::apertura, P::apertura, info.cigar);
+    info.start_s1 = filaIni;
+    info.end_s1 = mejor.fila - 1;
+    info.start_s2 = colIni;
+    info.end_s2 = mejor.columna - 1;
+    resultado.alineamientos.push_back(info);
   }
   return resultado;
 }
 
+// Alineamiento local con el esquema de puntuacion elegido en tiempo de ejecucion
+ResultadoAlineamientoLocal alineamientoLocal(const string &s1, const string &s2, EsquemaPuntuacion esquema,
+                                             bool guardarMatriz = false, size_t maxAlineamientos = 1000) {
+  switch (esquema) {
+  case EsquemaPuntuacion::Transiciones:
+    return alineamientoLocal<PuntuacionTransiciones>(s1, s2, guardarMatriz, maxAlineamientos);
+  case EsquemaPuntuacion::Blastn:
+    return alineamientoLocalAfin<PuntuacionBlastn>(s1, s2);
+  default:
+    return alineamientoLocal<PuntuacionEstandar>(s1, s2, guardarMatriz, maxAlineamientos);
+  }
+}
+
+// Mejor score local y su celda final con la politica P, en memoria O(m). Con politicas afines usa la
+// recurrencia de Gotoh: E guarda el mejor score que termina en gap vertical y F en gap horizontal.
+template <class P> MejorCeldaLocal alineamientoLocalScoreEscalar(const string &s1, const string &s2) {
+  int n = s1.length();
+  int m = s2.length();
+  vector<int> H(m + 1, 0), E(m + 1, MENOS_INFINITO);
+  MejorCeldaLocal mejor = {0, 0, 0};
+
+  for (int i = 1; i <= n; ++i) {
+    int diagonal = 0;
+    int F = MENOS_INFINITO;
+    for (int j = 1; j <= m; ++j) {
+      int scoreDiagonal = diagonal + P::sustitucion(s1[i - 1], s2[j - 1]);
+      diagonal = H[j];
+      if constexpr (P::esAfin) {
+        E[j] = max(E[j], H[j] + P::apertura) + P::extension;
+        F = max(F, H[j - 1] + P::apertura) + P::extension;
+        H[j] = max({0, scoreDiagonal, E[j], F});
+      } else {
+        H[j] = max({0, scoreDiagonal, H[j] + P::extension, H[j - 1] + P::extension});
+      }
+      if (H[j] > mejor.score)
+        mejor = {H[j], i, j};
+    }
+  }
+  return mejor;
+}
+
+// Smith-Waterman vectorial de Farrar con perfil en franjas ("striped"). Las columnas se reparten en ANCHO
+// carriles de 'segmentos' celdas: la columna j va al carril j / segmentos del vector j % segmentos. Asi la
+// diagonal y E pasan de un vector al mismo de la fila anterior y solo F (gap horizontal) cruza carriles;
+// se arrastra desplazando un carril y se corrige al final de la fila con el lazo perezoso de F, que
+// casi siempre termina en la primera vuelta. Los scores son enteros sin signo con suma saturada: el
+// piso en 0 es el del alineamiento local (E y F tambien se pueden acotar en 0 sin cambiar H) y las
+// sustituciones negativas se guardan en el perfil con un sesgo que se resta despues.
+template <typename T> struct CarrilesAVX2 {
+  static constexpr int ANCHO = 32 / sizeof(T);
+
+  __attribute__((target("avx2"))) static __m256i repetir(int x) {
+    if constexpr (sizeof(T) == 1)
+      return _mm256_set1_epi8((char)x);
+    else
+      return _mm256_set1_epi16((short)x);
+  }
+  __attribute__((target("avx2"))) static __m256i sumar(__m256i a, __m256i b) {
+    if constexpr (sizeof(T) == 1)
+      return _mm256_adds_epu8(a, b);
+    else
+      return _mm256_adds_epu16(a, b);
+  }
+  __attribute__((target("avx2"))) static __m256i restar(__m256i a, __m256i b) {
+    if constexpr (sizeof(T) == 1)
+      return _mm256_subs_epu8(a, b);
+    else
+      return _mm256_subs_epu16(a, b);
+  }
+  __attribute__((target("avx2"))) static __m256i maximo(__m256i a, __m256i b) {
+    if constexpr (sizeof(T) == 1)
+      return _mm256_max_epu8(a, b);
+    else
+      return _mm256_max_epu16(a, b);
+  }
+  // Sube cada valor un carril (el carril 0 recibe 0), cruzando la mitad de 128 bits
+  __attribute__((target("avx2"))) static __m256i desplazar(__m256i v) {
+    return _mm256_alignr_epi8(v, _mm256_permute2x128_si256(v, v, 0x08), 16 - sizeof(T));
+  }
+  // true si a > b en algun carril
+  __attribute__((target("avx2"))) static bool algunoMayor(__m256i a, __m256i b) {
+    __m256i menorIgual = sizeof(T) == 1 ? _mm256_cmpeq_epi8(_mm256_max_epu8(a, b), b)
+                                        : _mm256_cmpeq_epi16(_mm256_max_epu16(a, b), b);
+    return _mm256_movemask_epi8(menorIgual) != -1;
+  }
+  // Primera columna (en el orden original, no en franjas) de una fila de 'segmentos' vectores que vale x:
+  // en cada segmento s el primer carril igual da la columna carril * segmentos + s, y se toma la menor
+  __attribute__((target("avx2"))) static int primeraColumna(const __m256i *h, int segmentos, int x) {
+    __m256i vx = repetir(x);
+    int primera = numeric_limits<int>::max();
+    for (int s = 0; s < segmentos; ++s) {
+      __m256i igual = sizeof(T) == 1 ? _mm256_cmpeq_epi8(_mm256_loadu_si256(h + s), vx)
+                                     : _mm256_cmpeq_epi16(_mm256_loadu_si256(h + s), vx);
+      uint32_t mascara = _mm256_movemask_epi8(igual);
+      if (mascara != 0)
+        primera = min(primera, (int)(__builtin_ctz(mascara) / sizeof(T)) * segmentos + s);
+    }
+    return primera;
+  }
+  __attribute__((target("avx2"))) static int maximoHorizontal(__m256i v) {
+    T valores[ANCHO];
+    _mm256_storeu_si256((__m256i *)valores, v);
+    return *max_element(valores, valores + ANCHO);
+  }
+};
+
+// Perfil en franjas de la secuencia de las columnas para cada caracter distinto de la de las filas:
+// fila(c)[s * ANCHO + k] es el score de c frente a columnas[k * segmentos + s] mas el sesgo (el sesgo
+// solo en las celdas de relleno, mas alla del final). Con 'transpuesto' las filas son s2 y las columnas
+// s1, y la sustitucion se evalua igual como (caracter de s1, caracter de s2).
+template <class P, typename T> struct PerfilStriped {
+  int columnas;
+  int segmentos;
+  int sesgo;
+  int maximo; // mayor valor del perfil
+  array<int, 256> indice;
+  vector<T> valores;
+
+  PerfilStriped(const string &filas, const string &cols, bool transpuesto) : columnas(cols.length()) {
+    const int ancho = 32 / sizeof(T);
+    segmentos = max(1, (columnas + ancho - 1) / ancho);
+    indice.fill(-1);
+    vector<char> caracteres;
+    for (unsigned char c : filas)
+      if (indice[c] < 0) {
+        indice[c] = caracteres.size();
+        caracteres.push_back(c);
+      }
+    auto score = [&](char deFila, char deColumna) {
+      return transpuesto ? P::sustitucion(deColumna, deFila) : P::sustitucion(deFila, deColumna);
+    };
+    int minimo = 0;
+    maximo = 0;
+    for (char c : caracteres)
+      for (char d : cols) {
+        minimo = min(minimo, score(c, d));
+        maximo = max(maximo, score(c, d));
+      }
+    sesgo = -minimo;
+    maximo += sesgo;
+    size_t tamFila = (size_t)segmentos * ancho;
+    valores.assign(caracteres.size() * tamFila, sesgo);
+    for (size_t c = 0; c < caracteres.size(); ++c)
+      for (int j = 0; j < columnas; ++j)
+        valores[c * tamFila + (size_t)(j % segmentos) * ancho + j / segmentos] = score(caracteres[c], cols[j]) + sesgo;
+  }
+
+  const T *fila(char c) const { return &valores[(size_t)indice[(unsigned char)c] * segmentos * (32 / sizeof(T))]; }
+};
+
+// Mejor celda local con el kernel striped de enteros T; 'filas' recorre las filas del kernel y el perfil
+// sus columnas. Devuelve false si algun score pudo saturarse (hay que repetir con enteros mas anchos).
+// Entre empates se queda con la primera celda en orden de filas de s1: sin transponer se compara el
+// maximo de cada fila y, cuando mejora, se guarda la fila para buscar al final la primera columna con
+// ese score; transpuesto, cada fila del kernel es una columna de s2 y en cada empate con el mejor se
+// busca la primera fila de s1 que lo alcanza.
+template <class P, typename T>
+__attribute__((target("avx2"))) static bool smithWatermanStripedAVX2(const string &filas,
+                                                                       const PerfilStriped<P, T> &perfil,
+                                                                       bool transpuesto, MejorCeldaLocal &mejor) {
+  using C = CarrilesAVX2<T>;
+  constexpr int ANCHO = C::ANCHO;
+  const int limite = numeric_limits<T>::max() - perfil.maximo; // scores desde aqui pueden saturarse
+  const int aperturaExtension = -(P::apertura + P::extension), extension = -P::extension;
+  int n = filas.length(), m = perfil.columnas;
+  int segmentos = perfil.segmentos;
+  mejor = {0, 0, 0};
+  if (n == 0 || m == 0)
+    return true;
+  if (limite <= 0 || aperturaExtension > numeric_limits<T>::max())
+    return false;
+
+  // Filas de H (la anterior y la actual), E y la copia de la fila del mejor score, de a 'segmentos' vectores
+  size_t tam = (size_t)segmentos * ANCHO;
+  vector<T> bufCargar(tam, 0), bufGuardar(tam, 0), bufE(tam, 0), filaMejor;
+  __m256i *hCargar = (__m256i *)bufCargar.data(), *hGuardar = (__m256i *)bufGuardar.data();
+  __m256i *vE = (__m256i *)bufE.data();
+  const __m256i vSesgo = C::repetir(perfil.sesgo);
+  const __m256i vAperturaExtension = C::repetir(aperturaExtension);
+  const __m256i vExtension = C::repetir(extension);
+  // Celda k de la fila del kernel guardada en h (k en el orden de las columnas)
+  for (int i = 1; i <= n; ++i) {
+    const __m256i *p = (const __m256i *)perfil.fila(filas[i - 1]);
+    __m256i vF = _mm256_setzero_si256();
+    __m256i vMaxFila = _mm256_setzero_si256();
+    // H(i-1, j-1) del segmento 0 es el ultimo segmento de la fila anterior, un carril mas arriba
+    __m256i vH = C::desplazar(_mm256_loadu_si256(hGuardar + segmentos - 1));
+    swap(hCargar, hGuardar);
+    for (int s = 0; s < segmentos; ++s) {
+      vH = C::restar(C::sumar(vH, _mm256_loadu_si256(p + s)), vSesgo);
+      __m256i e = _mm256_loadu_si256(vE + s);
+      vH = C::maximo(C::maximo(vH, e), vF);
+      vMaxFila = C::maximo(vMaxFila, vH);
+      _mm256_storeu_si256(hGuardar + s, vH);
+      // E y F de la celda siguiente: abrir desde H o extender
+      vH = C::restar(vH, vAperturaExtension);
+      _mm256_storeu_si256(vE + s, C::maximo(C::restar(e, vExtension), vH));
+      vF = C::maximo(C::restar(vF, vExtension), vH);
+      vH = _mm256_loadu_si256(hCargar + s);
+    }
+    // Lazo perezoso: F que cruza al carril siguiente mientras todavia pueda mejorar algun H
+    vF = C::desplazar(vF);
+    int s = 0;
+    while (C::algunoMayor(vF, C::restar(_mm256_loadu_si256(hGuardar + s), vAperturaExtension))) {
+      __m256i h = C::maximo(_mm256_loadu_si256(hGuardar + s), vF);
+      _mm256_storeu_si256(hGuardar + s, h);
+      vMaxFila = C::maximo(vMaxFila, h);
+      _mm256_storeu_si256(vE + s, C::maximo(_mm256_loadu_si256(vE + s), C::restar(h, vAperturaExtension)));
+      vF = C::restar(vF, vExtension);
+      if (++s == segmentos) {
+        s = 0;
+        vF = C::desplazar(vF);
+      }
+    }
+
+    // Transpuesto tambien interesan los empates: pueden estar en una fila de s1 anterior
+    int umbral = transpuesto && mejor.score > 0 ? mejor.score - 1 : mejor.score;
+    if (!C::algunoMayor(vMaxFila, C::repetir(umbral)))
+      continue;
+    int maximoFila = C::maximoHorizontal(vMaxFila);
+    if (maximoFila >= limite)
+      return false;
+    if (transpuesto) {
+      MejorCeldaLocal candidata = {maximoFila, C::primeraColumna(hGuardar, segmentos, maximoFila) + 1, i};
+      if (mejorQue(candidata, mejor))
+        mejor = candidata;
+    } else {
+      mejor = {maximoFila, i, 0};
+      filaMejor.assign((const T *)hGuardar, (const T *)hGuardar + tam);
+    }
+  }
+
+  if (!transpuesto && mejor.score > 0) {
+    mejor.columna = C::primeraColumna((const __m256i *)filaMejor.data(), segmentos, mejor.score) + 1;
+  }
+  return true;
+}
+
+// Striped con enteros T sobre la secuencia mas corta; false si se saturo
+template <class P, typename T>
+static bool alineamientoLocalStriped(const string &s1, const string &s2, MejorCeldaLocal &mejor) {
+  bool transpuesto = s1.length() < s2.length();
+  const string &filas = transpuesto ? s2 : s1;
+  PerfilStriped<P, T> perfil(filas, transpuesto ? s1 : s2, transpuesto);
+  return smithWatermanStripedAVX2<P, T>(filas, perfil, transpuesto, mejor);
+}
+
+// Mejor score local y su celda final con la politica P en memoria lineal. Con AVX2 se usa el kernel
+// striped sobre la secuencia mas corta (el perfil entra en cache y la otra se recorre una sola vez):
+// primero con 32 carriles de 8 bits; si se satura (el kernel corta en cuanto un score se acerca a 255),
+// se repite con 16 bits y, si tambien, con el escalar de 32 bits. Mismo resultado, empates incluidos,
+// que alineamientoLocalScoreEscalar.
+template <class P> MejorCeldaLocal alineamientoLocalScore(const string &s1, const string &s2) {
+  static const bool usarAVX2 = nivelSIMD() >= NivelSIMD::AVX2;
+  MejorCeldaLocal mejor;
+  if (usarAVX2 && (alineamientoLocalStriped<P, uint8_t>(s1, s2, mejor) ||
+                   alineamientoLocalStriped<P, uint16_t>(s1, s2, mejor)))
+    return mejor;
+  return alineamientoLocalScoreEscalar<P>(s1, s2);
+}
+
+// Cuantos pares de un lote tuvieron que repetirse con enteros mas anchos
+struct EstadisticasRescate {
+  size_t pares = 0;
+  size_t rescates16 = 0; // saturaron 8 bits
+  size_t rescates32 = 0; // saturaron tambien 16 bits
+};
+
+// alineamientoLocalScore(consulta, objetivo) para cada objetivo. El perfil de la consulta se arma una
+// sola vez por ancho; todo el lote pasa por 8 bits y solo los pares saturados se repiten con 16 bits y
+// luego con 32.
+template <class P>
+vector<MejorCeldaLocal> alineamientoLocalScoreLote(const string &consulta, const vector<string> &objetivos,
+                                                   EstadisticasRescate *estadisticas = nullptr) {
+  vector<MejorCeldaLocal> mejores(objetivos.size());
+  vector<size_t> pendientes;
+  static const bool usarAVX2 = nivelSIMD() >= NivelSIMD::AVX2;
+  if (usarAVX2) {
+    // El perfil necesita una fila por cada caracter que aparezca en algun objetivo
+    bool presente[256] = {};
+    string alfabeto;
+    for (const auto &objetivo : objetivos)
+      for (unsigned char c : objetivo)
+        if (!presente[c]) {
+          presente[c] = true;
+          alfabeto += c;
+        }
+    PerfilStriped<P, uint8_t> perfil8(alfabeto, consulta, true);
+    for (size_t k = 0; k < objetivos.size(); ++k)
+      if (!smithWatermanStripedAVX2<P, uint8_t>(objetivos[k], perfil8, true, mejores[k]))
+        pendientes.push_back(k);
+    if (estadisticas)
+      estadisticas->rescates16 += pendientes.size();
+
+    if (!pendientes.empty()) {
+      PerfilStriped<P, uint16_t> perfil16(alfabeto, consulta, true);
+      vector<size_t> saturados;
+      for (size_t k : pendientes)
+        if (!smithWatermanStripedAVX2<P, uint16_t>(objetivos[k], perfil16, true, mejores[k]))
+          saturados.push_back(k);
+      pendientes.swap(saturados);
+    }
+  } else {
+    for (size_t k = 0; k < objetivos.size(); ++k)
+      pendientes.push_back(k);
+  }
+  if (estadisticas) {
+    estadisticas->pares += objetivos.size();
+    if (usarAVX2)
+      estadisticas->rescates32 += pendientes.size();
+  }
+  for (size_t k : pendientes)
+    mejores[k] = alineamientoLocalScoreEscalar<P>(consulta, objetivos[k]);
+  return mejores;
+}
+
+// Mejor score local con el esquema elegido en tiempo de ejecucion
+MejorCeldaLocal alineamientoLocalScore(const string &s1, const string &s2, EsquemaPuntuacion esquema) {
+  switch (esquema) {
+  case EsquemaPuntuacion::Transiciones:
+    return alineamientoLocalScore<PuntuacionTransiciones>(s1, s2);
+  case EsquemaPuntuacion::Blastn:
+    return alineamientoLocalScore<PuntuacionBlastn>(s1, s2);
+  default:
+    return alineamientoLocalScore<PuntuacionEstandar>(s1, s2);
+  }
+}
+
+// Inicio del alineamiento local con politica lineal que termina en la celda 'fin': pasada inversa desde
+// esa celda (s1 y s2 leidos hacia atras) con el score anclado en ella. Todo sufijo de un alineamiento
+// optimo suma mas de 0 (si no, recortarlo daria mas), asi que las celdas con score <= 0 se descartan y
+// en cada fila solo se recorre el tramo de columnas vivas alrededor del camino. El inicio es la primera
+// celda, en orden de filas de la pasada inversa, que alcanza fin.score: el alineamiento optimo mas corto
+// hacia s1. Devuelve la celda (fila, columna) del inicio, con la misma convencion que el traceback.
+template <class P> pair<int, int> inicioLocalLineal(const string &s1, const string &s2, const MejorCeldaLocal &fin) {
+  vector<int> anterior(fin.columna + 1, MENOS_INFINITO), actual(fin.columna + 1, MENOS_INFINITO);
+  anterior[0] = 0; // la propia celda final
+  int desde = 0, hasta = 0; // columnas vivas de la fila anterior
+  for (int i = 1; i <= fin.fila && desde <= hasta; ++i) {
+    char c1 = s1[fin.fila - i];
+    int nuevoDesde = -1, nuevoHasta = -1;
+    int izquierda = MENOS_INFINITO;
+    // Una celda vive si le llega algo de la fila anterior (columnas desde..hasta+1) o de su izquierda
+    for (int j = desde; j <= fin.columna && (j <= hasta + 1 || izquierda > 0); ++j) {
+      int h = izquierda + P::extension;
+      if (j <= hasta)
+        h = max(h, anterior[j] + P::extension);
+      if (j > desde)
+        h = max(h, anterior[j - 1] + P::sustitucion(c1, s2[fin.columna - j]));
+      if (h >= fin.score)
+        return {fin.fila - i, fin.columna - j};
+      if (h <= 0) {
+        h = MENOS_INFINITO;
+      } else {
+        if (nuevoDesde < 0)
+          nuevoDesde = j;
+        nuevoHasta = j;
+      }
+      actual[j] = izquierda = h;
+    }
+    // Se limpia la fila que se reutiliza para que lo que quede fuera del tramo nuevo cuente como muerto
+    fill(anterior.begin() + desde, anterior.begin() + hasta + 1, MENOS_INFINITO);
+    swap(anterior, actual);
+    if (nuevoDesde < 0)
+      break;
+    desde = nuevoDesde;
+    hasta = nuevoHasta;
+  }
+  return {fin.fila, fin.columna}; // no deberia pasar: el score de 'fin' siempre se alcanza
+}
+
+// Alineamiento local optimo en memoria O(n + m), sin matriz de traceback: la celda final sale de
+// alineamientoLocalScore (SIMD), la inicial de la pasada inversa acotada y el camino de Myers-Miller
+// global dentro de ese subrectangulo, cuyo optimo global es el score local. Se reporta un solo
+// alineamiento optimo; con gaps afines es alineamientoLocalAfin.
+template <class P = PuntuacionEstandar>
+ResultadoAlineamientoLocal alineamientoLocalEspacioLineal(const string &s1, const string &s2) {
+  if constexpr (P::esAfin) {
+    return alineamientoLocalAfin<P>(s1, s2);
+  }
+  ResultadoAlineamientoLocal resultado;
+  MejorCeldaLocal fin = alineamientoLocalScore<P>(s1, s2);
+  resultado.scoreMayor = fin.score;
+  if (fin.score > 0) {
+    pair<int, int> inicio = inicioLocalLineal<P>(s1, s2, fin);
+    AlineamientoInfo info;
+    hirschbergAfin<P>(s1.data() + inicio.first, fin.fila - inicio.first, s2.data() + inicio.second,
+                      fin.columna - inicio.second, P::apertura, P::apertura, info.cigar);
+    info.start_s1 = inicio.first;
+    info.end_s1 = fin.fila - 1;
+    info.start_s2 = inicio.second;
+    info.end_s2 = fin.columna - 1;
+    resultado.alineamientos.push_back(info);
+  }
+  return resultado;
+}
+
+// Alineamiento local en memoria lineal con el esquema elegido en tiempo de ejecucion
+ResultadoAlineamientoLocal alineamientoLocalEspacioLineal(const string &s1, const string &s2,
+                                                          EsquemaPuntuacion esquema) {
+  switch (esquema) {
+  case EsquemaPuntuacion::Transiciones:
+    return alineamientoLocalEspacioLineal<PuntuacionTransiciones>(s1, s2);
+  case EsquemaPuntuacion::Blastn:
+    return alineamientoLocalAfin<PuntuacionBlastn>(s1, s2);
+  default:
+    return alineamientoLocalEspacioLineal<PuntuacionEstandar>(s1, s2);
+  }
+}
+
+// Alineamiento local del top-k: su score y sus coordenadas
+struct AlineamientoNoSolapado {
+  int score;
+  AlineamientoInfo info;
+};
+
+// Matriz de scores que en cada fila i solo guarda las columnas j >= i + diagonalMin, mas una celda en 0 a
+// su izquierda; las demas valen 0 y no ocupan memoria. Las celdas vecinas (arriba, izquierda, diagonal)
+// de una celda guardada estan siempre guardadas, asi la recurrencia no revisa limites. Con diagonalMin
+// <= 1 - filas es la matriz completa; con 1 en una autocomparacion, el triangulo superior estricto.
+class MatrizTriangular {
+public:
+  MatrizTriangular(int filas, int columnas, int diagonalMin) {
+    long long total = 0;
+    for (int i = 0; i < filas; ++i) {
+      primera.push_back(min<long long>(columnas, max<long long>(1, (long long)i + diagonalMin)));
+      inicioFila.push_back(total - (primera[i] - 1));
+      total += columnas - primera[i] + 1;
+    }
+    valores.assign(total, 0);
+  }
+
+  // Primera columna guardada de la fila (sin contar la celda en 0 de la izquierda)
+  int primeraColumna(int i) const { return primera[i]; }
+  size_t tamano() const { return valores.size(); }
+  size_t indice(int i, int j) const { return inicioFila[i] + j; }
+  int &operator()(int i, int j) { return valores[inicioFila[i] + j]; }
+  int operator()(int i, int j) const { return valores[inicioFila[i] + j]; }
+
+private:
+  vector<int> primera;
+  vector<long long> inicioFila; // valores[inicioFila[i] + j] es la celda (i, j)
+  vector<int> valores;
+};
+
+// Los k mejores alineamientos locales que no comparten ningun par alineado (Waterman-Eggert). Tras
+// reportar uno, sus pares (i, j) quedan bloqueados: esas celdas ya no pueden venir por la diagonal (los
+// gaps si pueden cruzarlas). Solo se recalcula la zona afectada: cada fila desde la primera del camino se
+// recorre en el tramo de columnas que cambio en la fila anterior (mas una) o que tiene celdas bloqueadas,
+// y sigue a la derecha mientras los valores cambien. Los scores solo bajan, asi que el maximo de cada
+// fila (primera columna) se vuelve a buscar solo si su celda cae en el tramo que cambio. Con
+// incremental = false se recalcula la matriz completa en cada paso (para comparar). La matriz de scores
+// ocupa O(n*m) enteros. Empates: como alineamientoLocal, la primera celda en orden de filas y en el
+// traceback diagonal, arriba, izquierda. Solo se llenan las celdas con j - i >= diagonalMin (i, j desde
+// 1); el resto queda en 0.
+template <class P>
+static vector<AlineamientoNoSolapado> watermanEggert(const string &s1, const string &s2, int k, int diagonalMin,
+                                                     bool incremental) {
+  static_assert(!P::esAfin, "Waterman-Eggert implementado para gaps lineales");
+  int n = s1.length(), m = s2.length();
+  MatrizTriangular H(n + 1, m + 1, diagonalMin);
+  vector<bool> bloqueada(H.tamano(), false);
+  auto estaBloqueada = [&](int i, int j) { return bloqueada[H.indice(i, j)]; };
+  auto calcular = [&](int i, int j) {
+    int h = max({0, H(i - 1, j) + P::extension, H(i, j - 1) + P::extension});
+    if (!estaBloqueada(i, j))
+      h = max(h, H(i - 1, j - 1) + P::sustitucion(s1[i - 1], s2[j - 1]));
+    return h;
+  };
+  // Maximo de cada fila (score y primera columna que lo alcanza)
+  vector<int> maxFila(n + 1, 0), colMaxFila(n + 1, 0);
+  auto buscarMaxFila = [&](int i) {
+    maxFila[i] = 0;
+    colMaxFila[i] = 0;
+    for (int j = H.primeraColumna(i); j <= m; ++j)
+      if (H(i, j) > maxFila[i]) {
+        maxFila[i] = H(i, j);
+        colMaxFila[i] = j;
+      }
+  };
+  for (int i = 1; i <= n; ++i) {
+    for (int j = H.primeraColumna(i); j <= m; ++j)
+      H(i, j) = calcular(i, j);
+    buscarMaxFila(i);
+  }
+
+  vector<AlineamientoNoSolapado> resultado;
+  vector<vector<int>> bloqueadasFila(n + 1); // columnas bloqueadas en este paso, por fila
+  while ((int)resultado.size() < k) {
+    int mejorFila = 0;
+    for (int i = 1; i <= n; ++i)
+      if (maxFila[i] > maxFila[mejorFila])
+        mejorFila = i;
+    if (mejorFila == 0)
+      break;
+
+    // Traceback sobre la matriz actual, bloqueando los pares alineados
+    AlineamientoNoSolapado hit;
+    hit.score = maxFila[mejorFila];
+    int i = mejorFila, j = colMaxFila[mejorFila];
+    hit.info.end_s1 = i - 1;
+    hit.info.end_s2 = j - 1;
+    int primeraFila = i;
+    while (H(i, j) > 0) {
+      if (!estaBloqueada(i, j) && H(i, j) == H(i - 1, j - 1) + P::sustitucion(s1[i - 1], s2[j - 1])) {
+        hit.info.cigar.agregarPar(s1[i - 1], s2[j - 1]);
+        bloqueada[H.indice(i, j)] = true;
+        bloqueadasFila[i].push_back(j);
+        primeraFila = i;
+        --i;
+        --j;
+      } else if (H(i, j) == H(i - 1, j) + P::extension) {
+        hit.info.cigar.agregar('D');
+        --i;
+      } else {
+        hit.info.cigar.agregar('I');
+        --j;
+      }
+    }
+    hit.info.cigar.invertir();
+    hit.info.start_s1 = i;
+    hit.info.start_s2 = j;
+    resultado.push_back(hit);
+
+    // Recalculo de la zona afectada: [desde, hasta] son las columnas que cambiaron en la fila anterior
+    int desde = m + 1, hasta = 0;
+    for (int fila = incremental ? primeraFila : 1; fila <= n; ++fila) {
+      int inicio = incremental ? desde : 1, obligatorio = incremental ? hasta + 1 : m;
+      for (int c : bloqueadasFila[fila]) {
+        inicio = min(inicio, c);
+        obligatorio = max(obligatorio, c);
+      }
+      bloqueadasFila[fila].clear();
+      if (inicio > m && fila > mejorFila)
+        break; // ya no cambia nada y no quedan celdas bloqueadas mas abajo
+      int cambioDesde = m + 1, cambioHasta = 0;
+      for (int col = max(inicio, H.primeraColumna(fila)); col <= m; ++col) {
+        int h = calcular(fila, col);
+        if (h != H(fila, col)) {
+          H(fila, col) = h;
+          cambioDesde = min(cambioDesde, col);
+          cambioHasta = col;
+        } else if (col > obligatorio) {
+          break;
+        }
+      }
+      if (!incremental || (cambioHasta > 0 && colMaxFila[fila] >= cambioDesde && colMaxFila[fila] <= cambioHasta))
+        buscarMaxFila(fila);
+      desde = cambioDesde;
+      hasta = cambioHasta;
+    }
+  }
+  return resultado;
+}
+
+template <class P = PuntuacionEstandar>
+vector<AlineamientoNoSolapado> mejoresAlineamientosLocales(const string &s1, const string &s2, int k,
+                                                           bool incremental = true) {
+  return watermanEggert<P>(s1, s2, k, -(int)s1.length(), incremental);
+}
+
+// Repeticiones internas de s: los k mejores alineamientos locales de s consigo misma, sin el trivial de
+// la diagonal principal y sin repetir cada par en espejo. Solo se llena el triangulo superior estricto
+// (j > i), con el mismo Waterman-Eggert de mejoresAlineamientosLocales: la mitad del trabajo y de la
+// memoria que mejoresAlineamientosLocales(s, s, 2k + 1), que ademas devuelve la diagonal y cada par dos
+// veces. En cada par, la primera copia (s1) es la de la izquierda.
+template <class P = PuntuacionEstandar>
+vector<AlineamientoNoSolapado> repeticionesInternas(const string &s, int k, bool incremental = true) {
+  return watermanEggert<P>(s, s, k, 1, incremental);
+}
+
+// Llenado del alineamiento local en paralelo por teselas. Entre hilos solo se intercambian el borde
+// inferior y el borde derecho de cada tesela. Si se pide, marca el traceback compacto (teselas alineadas
+// a palabras completas), copia las filas a matriz y junta las primeras maxCeldas celdas empatadas en el
+// maximo (cada tesela guarda a lo sumo maxCeldas: las primeras globales estan entre las de cada una).
+MejorCeldaLocal llenarLocalParalelo(const string &s1, const string &s2, int numHilos, int tamTesela,
+                                    MatrizTraceback *traceback = nullptr, MatrizScores *matriz = nullptr,
+                                    vector<pair<int, int>> *celdasMaxScore = nullptr, size_t maxCeldas = 1000) {
+  int n = s1.length();
+  int m = s2.length();
+  if (matriz)
+    matriz->redimensionar(n + 1, m + 1);
+  if (celdasMaxScore)
+    celdasMaxScore->clear();
+  if (n == 0 || m == 0)
+    return {0, 0, 0};
+  if (traceback) {
+    const int celdas = MatrizTraceback::CELDAS_POR_PALABRA;
+    tamTesela = (tamTesela + celdas - 1) / celdas * celdas;
+  }
+
+  int filasT = (n + tamTesela - 1) / tamTesela;
+  int colsT = (m + tamTesela - 1) / tamTesela;
+  vector<vector<int>> bordeInferior(colsT), bordeDerecho(filasT);
+  for (int tj = 0; tj < colsT; ++tj)
+    bordeInferior[tj].assign(min(m, (tj + 1) * tamTesela) - tj * tamTesela, 0);
+  for (int ti = 0; ti < filasT; ++ti)
+    bordeDerecho[ti].assign(min(n, (ti + 1) * tamTesela) - ti * tamTesela + 1, 0);
+  vector<MejorCeldaLocal> mejores(filasT * colsT, {0, 0, 0});
+  vector<vector<pair<int, int>>> celdasTesela(celdasMaxScore ? filasT * colsT : 0);
+
+  PoolHilos pool(numHilos);
+  recorrerTeselas(pool, filasT, colsT, [&](int ti, int tj) {
+    int r0 = ti * tamTesela + 1, r1 = min(n, (ti + 1) * tamTesela);
+    int c0 = tj * tamTesela + 1, c1 = min(m, (tj + 1) * tamTesela);
+    int ancho = c1 - c0 + 1;
+    const vector<int> &arriba = bordeInferior[tj];
+    vector<int> izquierda = bordeDerecho[ti];
+    vector<int> anterior(ancho + 1), actual(ancho + 1), derecha(r1 - r0 + 2);
+    MejorCeldaLocal mejor = {0, 0, 0};
+    vector<pair<int, int>> *celdas = celdasMaxScore ? &celdasTesela[ti * colsT + tj] : nullptr;
+
+    anterior[0] = izquierda[0];
+    copy(arriba.begin(), arriba.end(), anterior.begin() + 1);
+    derecha[0] = anterior[ancho];
+    for (int i = r0; i <= r1; ++i) {
+      actual[0] = izquierda[i - r0 + 1];
+      for (int c = 1; c <= ancho; ++c) {
+        int j = c0 + c - 1;
+        int scoreDiagonal = anterior[c - 1] + (s1[i - 1] == s2[j - 1] ? MATCH : MISMATCH);
+        int scoreArriba = anterior[c] + GAP;
+        int scoreIzquierda = actual[c - 1] + GAP;
+        actual[c] = max({0, scoreDiagonal, scoreArriba, scoreIzquierda});
+        if (traceback)
+          traceback->marcar(i, j, direccionesOptimas(scoreDiagonal, scoreArriba, scoreIzquierda, actual[c]));
+        if (actual[c] > mejor.score) {
+          mejor = {actual[c], i, j};
+          if (celdas)
+            celdas->assign(1, {i, j});
+        } else if (celdas && actual[c] == mejor.score && mejor.score > 0 && celdas->size() < maxCeldas) {
+          celdas->push_back({i, j});
+        }
+      }
+      if (matriz)
+        copy(actual.begin() + 1, actual.end(), matriz->fila(i) + c0);
+      derecha[i - r0 + 1] = actual[ancho];
+      swap(anterior, actual);
+    }
+    bordeInferior[tj].assign(anterior.begin() + 1, anterior.end());
+    bordeDerecho[ti] = derecha;
+    mejores[ti * colsT + tj] = mejor;
+  });
+
+  MejorCeldaLocal mejor = {0, 0, 0};
+  for (const auto &candidata : mejores) {
+    if (candidata.score > 0 && (mejor.score == 0 || mejorQue(candidata, mejor)))
+      mejor = candidata;
+  }
+  if (celdasMaxScore && mejor.score > 0) {
+    for (int t = 0; t < filasT * colsT; ++t) {
+      if (mejores[t].score == mejor.score)
+        celdasMaxScore->insert(celdasMaxScore->end(), celdasTesela[t].begin(), celdasTesela[t].end());
+    }
+    sort(celdasMaxScore->begin(), celdasMaxScore->end()); // mismo orden (por filas) que el llenado serial
+    if (celdasMaxScore->size() > maxCeldas)
+      celdasMaxScore->resize(maxCeldas);
+  }
+  return mejor;
+}
+
+// Score del alineamiento local con llenado paralelo; memoria O(n + m)
+MejorCeldaLocal alineamientoLocalScoreParalelo(const string &s1, const string &s2, int numHilos, int tamTesela = 256) {
+  return llenarLocalParalelo(s1, s2, numHilos, tamTesela);
+}
+
+// Alineamiento local con llenado paralelo; el resultado es identico al de alineamientoLocal
+ResultadoAlineamientoLocal alineamientoLocalParalelo(const string &s1, const string &s2, int numHilos,
+                                                     int tamTesela = 256, bool guardarMatriz = false,
+                                                     size_t maxAlineamientos = 1000) {
+  ResultadoAlineamientoLocal resultado;
+  MatrizTraceback traceback(s1.length(), s2.length(), false);
+  vector<pair<int, int>> celdasMaxScore;
+  resultado.scoreMayor = llenarLocalParalelo(s1, s2, numHilos, tamTesela, &traceback,
+                                             guardarMatriz ? &resultado.matrizScores : nullptr, &celdasMaxScore,
+                                             maxAlineamientos)
+                             .score;
+  ExtremosAlineamientos reportados;
+  for (const auto &celda : celdasMaxScore) {
+    reconstruir(s1, s2, traceback, celda.first, celda.second, resultado.alineamientos, reportados);
+  }
+  return resultado;
+}
+
+// Alineamiento local restringido a la banda de diagonales diagonalMin <= j - i <= diagonalMax (i, j
+// desde 1, como en la matriz): misma recurrencia y mismos empates que alineamientoLocalScoreEscalar,
+// pero cada fila recorre solo las columnas de la banda. Fuera de ella las celdas valen 0 (un inicio
+// local) y la banda solo avanza a la derecha, asi H y E se reutilizan por columna sin limpiarlos.
+template <class P>
+MejorCeldaLocal alineamientoLocalBanda(const string &s1, const string &s2, int diagonalMin, int diagonalMax) {
+  int n = s1.length();
+  int m = s2.length();
+  vector<int> H(m + 1, 0), E(m + 1, MENOS_INFINITO);
+  MejorCeldaLocal mejor = {0, 0, 0};
+
+  for (int i = max(1, 1 - diagonalMax); i <= n && i + diagonalMin <= m; ++i) {
+    int desde = max(1, i + diagonalMin), hasta = min(m, i + diagonalMax);
+    int diagonal = H[desde - 1];
+    int izquierda = 0; // la celda a la izquierda de la banda
+    int F = MENOS_INFINITO;
+    for (int j = desde; j <= hasta; ++j) {
+      int scoreDiagonal = diagonal + P::sustitucion(s1[i - 1], s2[j - 1]);
+      diagonal = H[j];
+      if constexpr (P::esAfin) {
+        E[j] = max(E[j], H[j] + P::apertura) + P::extension;
+        F = max(F, izquierda + P::apertura) + P::extension;
+        H[j] = max({0, scoreDiagonal, E[j], F});
+      } else {
+        H[j] = max({0, scoreDiagonal, H[j] + P::extension, izquierda + P::extension});
+      }
+      izquierda = H[j];
+      if (H[j] > mejor.score)
+        mejor = {H[j], i, j};
+    }
+  }
+  return mejor;
+}
+
+// Prefiltro de semilla y extension (al estilo BLAST). Una semilla espaciada es un patron de '1' (posicion
+// que debe coincidir) y '0' (comodin); el patron contiguo "11111111111" es la palabra de 11 de blastn.
+// Las espaciadas como "111010010100110111" (PatternHunter) toleran mejor las sustituciones, pero abarcan
+// mas bases y las corta cualquier indel (ver bench-semillas).
+// Los umbrales van en unidades del score de una coincidencia de la politica.
+struct OpcionesSemillas {
+  string patron = "11111111111";
+  int xDrop = 10;               // la extension sin gaps corta al caer esto bajo su mejor score
+  int umbralSinGaps = 14;       // score minimo del segmento sin gaps para pasar al alineamiento con gaps
+  int anchoBanda = 16;          // diagonales a cada lado del mejor segmento en el alineamiento con gaps
+  size_t maxOcurrencias = 1000; // semillas mas frecuentes en la base (repeticiones) se ignoran
+};
+
+// Cuanto trabajo paso cada etapa del prefiltro
+struct EstadisticasSemillas {
+  size_t semillas = 0;    // coincidencias de semilla consulta-base
+  size_t extensiones = 0; // extensiones sin gaps (las semillas ya cubiertas por una se saltan)
+  size_t candidatos = 0;  // pares alineados con gaps en la banda
+};
+
+// Indice de semillas de un bloque de la base: para cada codigo (2 bits por posicion '1' del patron) las
+// posiciones donde aparece, contiguas y en orden de objetivo y posicion. Las posiciones son
+// desplazamientos en el bloque concatenado (hasta 4G bases). En vez de repartir cada posicion en su
+// cubeta de una tabla de 4^peso (un fallo de cache por base), se ordenan las claves (codigo,
+// desplazamiento) con radix sort estable de 8 bits, que escribe en secuencia. El peso del patron se
+// limita a 12 (la tabla de inicios tiene 4^peso + 1 entradas) y su largo a 32.
+class IndiceSemillas {
+public:
+  IndiceSemillas(const vector<string> &objetivos, const OpcionesSemillas &opciones)
+      : maxOcurrencias(opciones.maxOcurrencias), longitudPatron(opciones.patron.length()) {
+    for (int k = 0; k < longitudPatron; ++k)
+      if (opciones.patron[k] == '1')
+        desplazamientos.push_back(k);
+    if (desplazamientos.empty() || desplazamientos.size() > 12 || longitudPatron > 32) {
+      cerr << "Error: el patron de semilla debe tener entre 1 y 12 posiciones '1' y a lo sumo 32 de largo" << endl;
+      desplazamientos.clear();
+      return;
+    }
+    size_t bases = 0;
+    for (const auto &objetivo : objetivos)
+      bases += objetivo.length();
+    vector<uint64_t> claves;
+    claves.reserve(bases);
+    uint32_t desplazamiento = 0;
+    for (const auto &objetivo : objetivos) {
+      inicioObjetivo.push_back(desplazamiento);
+      recorrerCodigos(objetivo, [&](int pos, uint32_t codigo) {
+        claves.push_back((uint64_t)codigo << 32 | (desplazamiento + pos));
+      });
+      desplazamiento += objetivo.length();
+    }
+    vector<uint64_t> auxiliar(claves.size());
+    for (int bit = 32; bit < 32 + 2 * (int)desplazamientos.size(); bit += 8) {
+      size_t conteo[257] = {};
+      for (uint64_t clave : claves)
+        ++conteo[(clave >> bit & 255) + 1];
+      for (int c = 1; c <= 256; ++c)
+        conteo[c] += conteo[c - 1];
+      for (uint64_t clave : claves)
+        auxiliar[conteo[clave >> bit & 255]++] = clave;
+      claves.swap(auxiliar);
+    }
+    inicios.assign((1u << 2 * desplazamientos.size()) + 1, 0);
+    ocurrencias.resize(claves.size());
+    for (size_t k = 0; k < claves.size(); ++k) {
+      ocurrencias[k] = (uint32_t)claves[k];
+      ++inicios[(claves[k] >> 32) + 1];
+    }
+    for (size_t c = 1; c < inicios.size(); ++c)
+      inicios[c] += inicios[c - 1];
+  }
+
+  int longitud() const { return longitudPatron; }
+
+  // Llama a alEncontrar(i, objetivo, j) por cada semilla de consulta[i..] que aparece en objetivo[j..],
+  // con i creciente
+  template <typename F> void recorrer(const string &consulta, F &&alEncontrar) const {
+    if (desplazamientos.empty())
+      return;
+    recorrerCodigos(consulta, [&](int i, uint32_t codigo) {
+      uint32_t desde = inicios[codigo], hasta = inicios[codigo + 1];
+      if (hasta - desde > maxOcurrencias)
+        return;
+      for (uint32_t k = desde; k < hasta; ++k) {
+        uint32_t t = upper_bound(inicioObjetivo.begin(), inicioObjetivo.end(), ocurrencias[k]) - inicioObjetivo.begin();
+        alEncontrar(i, t - 1, (int)(ocurrencias[k] - inicioObjetivo[t - 1]));
+      }
+    });
+  }
+
+private:
+  // Codigo de la semilla en cada posicion de la secuencia. Las ultimas longitudPatron bases se llevan en
+  // una ventana de 2 bits por base que avanza una base por paso; el codigo sale de la ventana (directo si
+  // el patron es contiguo). Las ventanas con bases ambiguas no tienen codigo.
+  template <typename F> void recorrerCodigos(const string &sec, F &&alCodigo) const {
+    static const array<int8_t, 256> codigoBase = [] {
+      array<int8_t, 256> tabla;
+      tabla.fill(-1);
+      tabla['A'] = 0;
+      tabla['C'] = 1;
+      tabla['G'] = 2;
+      tabla['T'] = tabla['U'] = 3;
+      return tabla;
+    }();
+    const bool contiguo = (int)desplazamientos.size() == longitudPatron;
+    const uint64_t mascara = longitudPatron == 32 ? ~0ULL : (1ULL << 2 * longitudPatron) - 1;
+    uint64_t ventana = 0;
+    int validas = 0; // bases no ambiguas seguidas al final de la ventana
+    for (int k = 0; k < (int)sec.length(); ++k) {
+      int b = codigoBase[(unsigned char)sec[k]];
+      ventana = (ventana << 2 | (b & 3)) & mascara;
+      validas = b < 0 ? 0 : validas + 1;
+      if (validas < longitudPatron)
+        continue;
+      uint32_t codigo = 0;
+      if (contiguo) {
+        codigo = ventana;
+      } else {
+        for (int d : desplazamientos)
+          codigo = codigo << 2 | (ventana >> 2 * (longitudPatron - 1 - d) & 3);
+      }
+      alCodigo(k + 1 - longitudPatron, codigo);
+    }
+  }
+
+  size_t maxOcurrencias;
+  int longitudPatron;
+  vector<int> desplazamientos;    // posiciones '1' del patron
+  vector<uint32_t> inicioObjetivo; // desplazamiento de cada objetivo en el bloque
+  vector<uint32_t> inicios;        // [codigo, codigo + 1) en ocurrencias
+  vector<uint32_t> ocurrencias;    // desplazamientos, agrupados por codigo
+};
+
+// Extension sin gaps con X-drop de la semilla consulta[i..i+L) frente a objetivo[j..j+L): avanza hacia
+// cada lado mientras el score no caiga mas de xDrop bajo el mejor visto. Devuelve el score del mejor
+// segmento y en 'alcance' la posicion de la consulta donde se detuvo por la derecha.
+template <class P>
+int extenderSinGaps(const string &consulta, const string &objetivo, int i, int j, int L, int xDrop, int &alcance) {
+  int n = consulta.length(), m = objetivo.length();
+  int semilla = 0;
+  for (int k = 0; k < L; ++k)
+    semilla += P::sustitucion(consulta[i + k], objetivo[j + k]);
+
+  int score = 0, mejorDerecha = 0;
+  int k = L;
+  for (; i + k < n && j + k < m && score >= mejorDerecha - xDrop; ++k) {
+    score += P::sustitucion(consulta[i + k], objetivo[j + k]);
+    mejorDerecha = max(mejorDerecha, score);
+  }
+  alcance = i + k;
+
+  int mejorIzquierda = 0;
+  score = 0;
+  for (k = 1; i - k >= 0 && j - k >= 0 && score >= mejorIzquierda - xDrop; ++k) {
+    score += P::sustitucion(consulta[i - k], objetivo[j - k]);
+    mejorIzquierda = max(mejorIzquierda, score);
+  }
+  return semilla + mejorDerecha + mejorIzquierda;
+}
+
+// Mejor score local de la consulta contra cada objetivo del bloque indexado, solo donde hay evidencia:
+// semillas -> extension sin gaps con X-drop (una por diagonal, las semillas que caen dentro de una
+// extension previa se saltan) -> alineamiento con gaps en una banda alrededor de la diagonal del mejor
+// segmento de cada objetivo. Los objetivos sin segmento sobre el umbral quedan con score 0. El score
+// es una cota inferior del exhaustivo (igual si el optimo cabe en la banda).
+template <class P>
+vector<MejorCeldaLocal> alineamientoLocalSemillas(const string &consulta, const vector<string> &objetivos,
+                                                  const IndiceSemillas &indice, const OpcionesSemillas &opciones,
+                                                  EstadisticasSemillas *estadisticas = nullptr) {
+  const int coincidencia = P::sustitucion('A', 'A');
+  const int xDrop = opciones.xDrop * coincidencia, umbral = opciones.umbralSinGaps * coincidencia;
+  vector<MejorCeldaLocal> mejores(objetivos.size(), {0, 0, 0});
+  vector<pair<int, int>> mejorSegmento(objetivos.size(), {0, 0}); // (score, diagonal j - i)
+  vector<uint32_t> candidatos;
+  unordered_map<uint64_t, int> alcanceDiagonal; // (objetivo, diagonal) -> fin de la ultima extension
+  size_t semillas = 0, extensiones = 0;
+
+  indice.recorrer(consulta, [&](int i, uint32_t t, int j) {
+    ++semillas;
+    uint64_t clave = (uint64_t)t << 32 | (uint32_t)(j - i);
+    auto it = alcanceDiagonal.find(clave);
+    if (it != alcanceDiagonal.end() && i < it->second)
+      return;
+    ++extensiones;
+    int alcance;
+    int score = extenderSinGaps<P>(consulta, objetivos[t], i, j, indice.longitud(), xDrop, alcance);
+    alcanceDiagonal[clave] = alcance;
+    if (score >= umbral && score > mejorSegmento[t].first) {
+      if (mejorSegmento[t].first == 0)
+        candidatos.push_back(t);
+      mejorSegmento[t] = {score, j - i};
+    }
+  });
+
+  for (uint32_t t : candidatos) {
+    int diagonal = mejorSegmento[t].second;
+    mejores[t] = alineamientoLocalBanda<P>(consulta, objetivos[t], diagonal - opciones.anchoBanda,
+                                          diagonal + opciones.anchoBanda);
+  }
+  if (estadisticas) {
+    estadisticas->semillas += semillas;
+    estadisticas->extensiones += extensiones;
+    estadisticas->candidatos += candidatos.size();
+  }
+  return mejores;
+}
+
+// Lectura de FASTA en flujo: un registro a la vez, sin cargar el archivo completo. El nombre es el
+// encabezado hasta el primer espacio; la secuencia se pasa a mayusculas y pierde los espacios.
+struct RegistroFasta {
+  string nombre;
+  string secuencia;
+};
+
+class LectorFasta {
+public:
+  explicit LectorFasta(const string &ruta) : archivo(ruta) {
+    if (!archivo.is_open())
+      cerr << "Error al abrir el archivo " << ruta << endl;
+  }
+
+  bool abierto() const { return archivo.is_open(); }
+
+  // Lee el siguiente registro; false al llegar al final
+  bool siguiente(RegistroFasta &registro) {
+    string linea;
+    while (encabezado.empty() && getline(archivo, linea)) {
+      if (!linea.empty() && linea[0] == '>')
+        encabezado = linea;
+    }
+    if (encabezado.empty())
+      return false;
+    size_t finNombre = encabezado.find_first_of(" \t\r", 1);
+    registro.nombre = encabezado.substr(1, finNombre == string::npos ? string::npos : finNombre - 1);
+    registro.secuencia.clear();
+    encabezado.clear();
+    while (getline(archivo, linea)) {
+      if (!linea.empty() && linea[0] == '>') {
+        encabezado = linea;
+        break;
+      }
+      for (char c : linea)
+        if (!isspace((unsigned char)c))
+          registro.secuencia += toupper((unsigned char)c);
+    }
+    return true;
+  }
+
+private:
+  ifstream archivo;
+  string encabezado; // encabezado ya leido del siguiente registro
+};
+
+// Secuencia de la base que entro al top-N de una consulta; guarda su copia para el traceback final
+struct AciertoBase {
+  int score;
+  size_t indice; // orden del registro en la base
+  string nombre;
+  string secuencia;
+};
+
+// Los N mejores aciertos de una consulta: monticulo acotado cuya raiz es el peor guardado, asi cada
+// candidato cuesta una comparacion y solo los que entran se copian. Entre empates gana el registro
+// que aparece antes en la base, para que el resultado no dependa del reparto entre hilos.
+class MejoresAciertos {
+public:
+  explicit MejoresAciertos(size_t capacidad = 0) : capacidad(capacidad) {}
+
+  bool admite(int score, size_t indice) const {
+    if (score <= 0 || capacidad == 0)
+      return false;
+    return monticulo.size() < capacidad || mejor(score, indice, monticulo.front().score, monticulo.front().indice);
+  }
+
+  void agregar(AciertoBase acierto) {
+    if (!admite(acierto.score, acierto.indice))
+      return;
+    if (monticulo.size() == capacidad) {
+      pop_heap(monticulo.begin(), monticulo.end(), compararMonticulo);
+      monticulo.pop_back();
+    }
+    monticulo.push_back(move(acierto));
+    push_heap(monticulo.begin(), monticulo.end(), compararMonticulo);
+  }
+
+  void combinar(MejoresAciertos &otro) {
+    for (auto &acierto : otro.monticulo)
+      agregar(move(acierto));
+    otro.monticulo.clear();
+  }
+
+  // Del mejor al peor
+  vector<AciertoBase> ordenados() {
+    sort_heap(monticulo.begin(), monticulo.end(), compararMonticulo);
+    return move(monticulo);
+  }
+
+private:
+  static bool mejor(int scoreA, size_t indiceA, int scoreB, size_t indiceB) {
+    return scoreA > scoreB || (scoreA == scoreB && indiceA < indiceB);
+  }
+  static bool compararMonticulo(const AciertoBase &a, const AciertoBase &b) {
+    return mejor(a.score, a.indice, b.score, b.indice);
+  }
+
+  size_t capacidad;
+  vector<AciertoBase> monticulo;
+};
+
+// Parametros del modo busqueda
+struct OpcionesBusqueda {
+  size_t maxAciertos = 10;       // top-N por consulta
+  int numHilos = 1;
+  size_t basesPorLote = 1 << 22; // residuos de la base en memoria a la vez
+  EsquemaPuntuacion esquema = EsquemaPuntuacion::Estandar;
+  bool prefiltro = false;        // semilla y extension en vez de Smith-Waterman exhaustivo
+  OpcionesSemillas semillas;
+};
+
+// Un acierto final ya alineado
+struct AciertoFinal {
+  int consulta;
+  AciertoBase objetivo;
+  AlineamientoInfo info;
+};
+
+// Busqueda de consultas contra una base FASTA. La base se lee por lotes de ~basesPorLote residuos
+// repartidos en un bloque por hilo; cada hilo pasa su bloque por alineamientoLocalScoreLote (striped de
+// 8 bits con rescate) para cada consulta y llena sus propios monticulos, sin bloqueos. Al final se
+// combinan los monticulos y solo los N aciertos de cada consulta se alinean en memoria lineal. Con
+// prefiltro cada hilo indexa las semillas de su bloque y usa alineamientoLocalSemillas; el traceback
+// final es exhaustivo sobre el par, asi que el score reportado puede superar al de la banda.
+template <class P>
+vector<AciertoFinal> buscarEnBase(const vector<RegistroFasta> &consultas, LectorFasta &base,
+                                  const OpcionesBusqueda &opciones, size_t &secuenciasLeidas, size_t &basesLeidas) {
+  int numHilos = max(1, opciones.numHilos);
+  PoolHilos pool(numHilos);
+  // [hilo][consulta]
+  vector<vector<MejoresAciertos>> mejores(
+      numHilos, vector<MejoresAciertos>(consultas.size(), MejoresAciertos(opciones.maxAciertos)));
+  vector<vector<RegistroFasta>> bloques(numHilos);
+  vector<vector<size_t>> indices(numHilos);
+  secuenciasLeidas = basesLeidas = 0;
+
+  auto procesarBloque = [&](int h) {
+    if (bloques[h].empty())
+      return;
+    vector<string> objetivos;
+    objetivos.reserve(bloques[h].size());
+    for (auto &registro : bloques[h])
+      objetivos.push_back(move(registro.secuencia));
+    unique_ptr<IndiceSemillas> indice;
+    if (opciones.prefiltro)
+      indice = make_unique<IndiceSemillas>(objetivos, opciones.semillas);
+    for (size_t q = 0; q < consultas.size(); ++q) {
+      vector<MejorCeldaLocal> scores =
+          indice ? alineamientoLocalSemillas<P>(consultas[q].secuencia, objetivos, *indice, opciones.semillas)
+                 : alineamientoLocalScoreLote<P>(consultas[q].secuencia, objetivos);
+      for (size_t k = 0; k < objetivos.size(); ++k) {
+        if (mejores[h][q].admite(scores[k].score, indices[h][k]))
+          mejores[h][q].agregar({scores[k].score, indices[h][k], bloques[h][k].nombre, objetivos[k]});
+      }
+    }
+    bloques[h].clear();
+    indices[h].clear();
+  };
+
+  RegistroFasta registro;
+  bool quedan = true;
+  while (quedan) {
+    // Cada registro va al bloque con menos residuos, para que los hilos terminen parejo
+    vector<size_t> basesBloque(numHilos, 0);
+    size_t basesLote = 0;
+    while (basesLote < opciones.basesPorLote && (quedan = base.siguiente(registro))) {
+      int h = min_element(basesBloque.begin(), basesBloque.end()) - basesBloque.begin();
+      basesBloque[h] += registro.secuencia.length();
+      basesLote += registro.secuencia.length();
+      indices[h].push_back(secuenciasLeidas++);
+      bloques[h].push_back(move(registro));
+    }
+    basesLeidas += basesLote;
+    pool.ejecutar(numHilos, procesarBloque);
+  }
+
+  vector<AciertoFinal> aciertos;
+  for (size_t q = 0; q < consultas.size(); ++q) {
+    for (int h = 1; h < numHilos; ++h)
+      mejores[0][q].combinar(mejores[h][q]);
+    for (auto &objetivo : mejores[0][q].ordenados())
+      aciertos.push_back({(int)q, move(objetivo), AlineamientoInfo()});
+  }
+  // Tracebacks solo de los aciertos finales, tambien en paralelo
+  pool.ejecutar(aciertos.size(), [&](int a) {
+    ResultadoAlineamientoLocal resultado =
+        alineamientoLocalEspacioLineal<P>(consultas[aciertos[a].consulta].secuencia, aciertos[a].objetivo.secuencia);
+    if (resultado.scoreMayor < aciertos[a].objetivo.score || resultado.alineamientos.empty()) {
+      cerr << "Error: el traceback de " << aciertos[a].objetivo.nombre << " no reproduce su score" << endl;
+    } else {
+      aciertos[a].objetivo.score = resultado.scoreMayor;
+      aciertos[a].info = resultado.alineamientos[0];
+    }
+  });
+  if (opciones.prefiltro) {
+    stable_sort(aciertos.begin(), aciertos.end(), [](const AciertoFinal &a, const AciertoFinal &b) {
+      return a.consulta < b.consulta || (a.consulta == b.consulta && a.objetivo.score > b.objetivo.score);
+    });
+  }
+  return aciertos;
+}
+
+// Busqueda con el esquema elegido en tiempo de ejecucion
+vector<AciertoFinal> buscarEnBase(const vector<RegistroFasta> &consultas, LectorFasta &base,
+                                  const OpcionesBusqueda &opciones, size_t &secuenciasLeidas, size_t &basesLeidas) {
+  switch (opciones.esquema) {
+  case EsquemaPuntuacion::Transiciones:
+    return buscarEnBase<PuntuacionTransiciones>(consultas, base, opciones, secuenciasLeidas, basesLeidas);
+  case EsquemaPuntuacion::Blastn:
+    return buscarEnBase<PuntuacionBlastn>(consultas, base, opciones, secuenciasLeidas, basesLeidas);
+  default:
+    return buscarEnBase<PuntuacionEstandar>(consultas, base, opciones, secuenciasLeidas, basesLeidas);
+  }
+}
+
+// Tabla de aciertos separada por tabuladores, una fila por acierto y coordenadas 1-based inclusivas
+// (como la salida tabular de BLAST)
+void imprimirAciertos(ostream &salida, const vector<RegistroFasta> &consultas, const vector<AciertoFinal> &aciertos) {
+  salida << "# consulta\tobjetivo\tidentidad\tcolumnas\tsustituciones\tgaps\tinicio_c\tfin_c\tinicio_o\tfin_o\t"
+            "score\tcigar"
+         << endl;
+  for (const auto &acierto : aciertos) {
+    const AlineamientoInfo &info = acierto.info;
+    EstadisticasAlineamiento e = info.cigar.estadisticas();
+    salida << consultas[acierto.consulta].nombre << '\t' << acierto.objetivo.nombre << '\t' << fixed
+           << setprecision(2) << 100 * e.identidad() << defaultfloat << '\t' << e.columnas << '\t'
+           << e.sustituciones << '\t' << e.gaps << '\t' << info.start_s1 + 1 << '\t' << info.end_s1 + 1 << '\t'
+           << info.start_s2 + 1 << '\t' << info.end_s2 + 1 << '\t' << acierto.objetivo.score << '\t'
+           << info.cigar.texto() << endl;
+  }
+}
+
+// Filas de la tabla de repeticiones de una secuencia (coordenadas 1-based inclusivas, como la de busqueda)
+void imprimirRepeticiones(ostream &salida, const string &nombre, const vector<AlineamientoNoSolapado> &repeticiones) {
+  for (const auto &repeticion : repeticiones) {
+    const AlineamientoInfo &info = repeticion.info;
+    salida << nombre << '\t' << repeticion.score << '\t' << fixed << setprecision(2)
+           << 100 * info.cigar.estadisticas().identidad() << defaultfloat << '\t' << info.start_s1 + 1 << '\t'
+           << info.end_s1 + 1 << '\t' << info.start_s2 + 1 << '\t' << info.end_s2 + 1 << '\t' << info.cigar.texto()
+           << endl;
+  }
+}
+
+// Benchmark: escalamiento del llenado por teselas (solo score y matriz para traceback) hasta 32 hilos
+void benchmarkHilos(int longitud) {
+  mt19937 generador(7);
+  string s1 = generarSecuenciaAleatoria(longitud, generador);
+  string s2 = mutarSecuencia(s1, 0.1, generador);
+  MejorCeldaLocal serial = alineamientoLocalScoreParalelo(s1, s2, 1, longitud + 1);
+  cout << "--- Benchmark hilos (longitud " << longitud << ", " << thread::hardware_concurrency()
+       << " nucleos) ---" << endl;
+  cout << setw(8) << "hilos" << setw(14) << "solo score" << setw(14) << "traceback" << endl;
+  for (int hilos : {1, 2, 4, 8, 16, 32}) {
+    MejorCeldaLocal mejor;
+    ResultadoAlineamientoLocal completo;
+    double tScore = medirSegundos([&] { mejor = alineamientoLocalScoreParalelo(s1, s2, hilos); });
+    double tMatriz = medirSegundos([&] { completo = alineamientoLocalParalelo(s1, s2, hilos, 256, false); });
+    if (mejor.score != serial.score || mejor.fila != serial.fila || mejor.columna != serial.columna ||
+        completo.scoreMayor != serial.score) {
+      cerr << "Error: el llenado paralelo no coincide con el serial" << endl;
+    }
+    cout << setw(8) << hilos << setw(14) << tScore << setw(14) << tMatriz << endl;
+  }
+}
+
+// Benchmark: score local de una consulta contra un objetivo largo (busqueda), escalar frente a striped
+void benchmarkStriped(int longitudObjetivo) {
+  mt19937 generador(21);
+  string consulta = generarSecuenciaAleatoria(300, generador);
+  string objetivo = generarSecuenciaAleatoria(longitudObjetivo, generador);
+  string copia = mutarSecuencia(consulta, 0.1, generador);
+  objetivo.replace(longitudObjetivo / 2, copia.length(), copia);
+  cout << "--- Benchmark Smith-Waterman striped (consulta 300 x objetivo " << longitudObjetivo << ") ---" << endl;
+  cout << setw(10) << "politica" << setw(12) << "escalar" << setw(12) << "striped" << setw(12) << "GCUPS" << setw(8)
+       << "score" << endl;
+  auto medir = [&](const char *nombre, auto politica) {
+    using P = decltype(politica);
+    MejorCeldaLocal escalar, striped;
+    double tEscalar = medirSegundos([&] { escalar = alineamientoLocalScoreEscalar<P>(consulta, objetivo); });
+    double tStriped = medirSegundos([&] { striped = alineamientoLocalScore<P>(consulta, objetivo); });
+    cout << setw(10) << nombre << setw(12) << tEscalar << setw(12) << tStriped << setw(12)
+         << 300.0 * longitudObjetivo / tStriped / 1e9 << setw(8) << striped.score << endl;
+    if (escalar.score != striped.score || escalar.fila != striped.fila || escalar.columna != striped.columna)
+      cerr << "Error: striped y escalar no coinciden (" << nombre << ")" << endl;
+  };
+  medir("estandar", PuntuacionEstandar());
+  medir("blastn", PuntuacionBlastn());
+}
+
+// Benchmark: una consulta contra un lote de objetivos (cribado) con el kernel de 8 bits y rescate, solo
+// 16 bits y escalar; cuenta cuantos pares saturan. Una parte de los objetivos trae una copia mutada de la
+// consulta, que son los que dan scores altos.
+void benchmarkRescate(int numObjetivos) {
+  mt19937 generador(23);
+  bool usarAVX2 = nivelSIMD() >= NivelSIMD::AVX2;
+  cout << "--- Benchmark 8 bits con rescate (" << numObjetivos << " objetivos de 200-600) ---" << endl;
+  cout << setw(10) << "politica" << setw(10) << "consulta" << setw(10) << "rescate16" << setw(10) << "rescate32"
+       << setw(12) << "8+rescate" << setw(12) << "solo 16" << setw(12) << "escalar" << endl;
+  auto medir = [&](const char *nombre, auto politica, int longitudConsulta, double fraccionHomologos) {
+    using P = decltype(politica);
+    string consulta = generarSecuenciaAleatoria(longitudConsulta, generador);
+    vector<string> objetivos;
+    for (int k = 0; k < numObjetivos; ++k) {
+      string objetivo = generarSecuenciaAleatoria(200 + generador() % 401, generador);
+      if (generador() % 1000 < fraccionHomologos * 1000) {
+        string copia = mutarSecuencia(consulta, 0.1, generador);
+        objetivo.replace(generador() % (objetivo.length() / 2), min(copia.length(), objetivo.length() / 2), copia);
+      }
+      objetivos.push_back(objetivo);
+    }
+    EstadisticasRescate estadisticas;
+    vector<MejorCeldaLocal> lote, escalar(objetivos.size()), solo16(objetivos.size());
+    double tLote = medirSegundos([&] { lote = alineamientoLocalScoreLote<P>(consulta, objetivos, &estadisticas); });
+    // Sin AVX2 (o con BIOINF_SIMD=escalar) la columna "solo 16" cae al escalar, igual que el lote
+    double tSolo16 = medirSegundos([&] {
+      PerfilStriped<P, uint16_t> perfil16("ACGT", consulta, true);
+      for (size_t k = 0; k < objetivos.size(); ++k)
+        if (!usarAVX2 || !smithWatermanStripedAVX2<P, uint16_t>(objetivos[k], perfil16, true, solo16[k]))
+          solo16[k] = alineamientoLocalScoreEscalar<P>(consulta, objetivos[k]);
+    });
+    double tEscalar = medirSegundos([&] {
+      for (size_t k = 0; k < objetivos.size(); ++k)
+        escalar[k] = alineamientoLocalScoreEscalar<P>(consulta, objetivos[k]);
+    });
+    cout << setw(10) << nombre << setw(10) << longitudConsulta << setw(9)
+         << 100.0 * estadisticas.rescates16 / estadisticas.pares << "%" << setw(9)
+         << 100.0 * estadisticas.rescates32 / estadisticas.pares << "%" << setw(12) << tLote << setw(12) << tSolo16
+         << setw(12) << tEscalar << endl;
+    for (size_t k = 0; k < objetivos.size(); ++k) {
+      bool iguales = lote[k].score == escalar[k].score && lote[k].fila == escalar[k].fila &&
+                     lote[k].columna == escalar[k].columna && solo16[k].score == escalar[k].score;
+      // Contra el alineamiento completo solo en unos pocos pares (cuesta la matriz de traceback)
+      if (k < 50)
+        iguales = iguales && alineamientoLocal<P>(consulta, objetivos[k], false).scoreMayor == lote[k].score;
+      if (!iguales) {
+        cerr << "Error: el lote con rescate no coincide con el escalar (" << nombre << ", objetivo " << k << ")"
+             << endl;
+        break;
+      }
+    }
+  };
+  medir("estandar", PuntuacionEstandar(), 150, 0.1);
+  medir("estandar", PuntuacionEstandar(), 300, 0.1);
+  medir("blastn", PuntuacionBlastn(), 150, 0.1);
+  medir("blastn", PuntuacionBlastn(), 300, 0.5);
+}
+
+// Benchmark: alineamiento local con traceback completo frente a la version en memoria lineal, con un
+// segmento homologo metido entre flancos aleatorios
+void benchmarkEspacioLineal(int longitud) {
+  mt19937 generador(29);
+  string s1 = generarSecuenciaAleatoria(longitud, generador);
+  string s2 = generarSecuenciaAleatoria(longitud / 4, generador) +
+              mutarSecuencia(s1.substr(longitud / 4, longitud / 2), 0.1, generador) +
+              generarSecuenciaAleatoria(longitud / 4, generador);
+  cout << "--- Benchmark alineamiento local en memoria lineal (" << s1.length() << " x " << s2.length() << ") ---"
+       << endl;
+  ResultadoAlineamientoLocal completo, lineal;
+  double tCompleto = medirSegundos([&] { completo = alineamientoLocal(s1, s2, false); });
+  double tLineal = medirSegundos([&] { lineal = alineamientoLocalEspacioLineal(s1, s2); });
+  // El traceback guarda 21 celdas por palabra de 64 bits; la version lineal, unas pocas filas de int
+  double mbTraceback = (double)s1.length() * s2.length() / 21 * 8 / 1e6;
+  double mbLineal = 4.0 * (s1.length() + s2.length()) * sizeof(int) / 1e6;
+  cout << setw(12) << "" << setw(12) << "segundos" << setw(12) << "~MB" << setw(8) << "score" << endl;
+  cout << setw(12) << "traceback" << setw(12) << tCompleto << setw(12) << mbTraceback << setw(8)
+       << completo.scoreMayor << endl;
+  cout << setw(12) << "lineal" << setw(12) << tLineal << setw(12) << mbLineal << setw(8) << lineal.scoreMayor << endl;
+  if (lineal.scoreMayor != completo.scoreMayor ||
+      (!lineal.alineamientos.empty() &&
+       puntuarCigar<PuntuacionEstandar>(lineal.alineamientos[0].cigar, s1, s2, lineal.alineamientos[0].start_s1,
+                                        lineal.alineamientos[0].start_s2) != completo.scoreMayor))
+    cerr << "Error: el alineamiento en memoria lineal no es optimo" << endl;
+}
+
+// Benchmark: entrada muy repetitiva (A^n frente a (AT)^n: cada A contra A es un empate con score 1, ~n^2
+// celdas) con el tope de alineamientos y sin el
+void benchmarkEmpates(int longitud) {
+  string s1(longitud, 'A'), s2;
+  for (int k = 0; k < longitud; ++k)
+    s2 += k % 2 == 0 ? 'A' : 'T';
+  cout << "--- Benchmark empates (" << longitud << " x " << longitud << ") ---" << endl;
+  cout << setw(12) << "tope" << setw(12) << "segundos" << setw(16) << "alineamientos" << endl;
+  for (size_t tope : {(size_t)1000, numeric_limits<size_t>::max()}) {
+    ResultadoAlineamientoLocal resultado;
+    double t = medirSegundos([&] { resultado = alineamientoLocal(s1, s2, false, tope); });
+    cout << setw(12) << (tope == numeric_limits<size_t>::max() ? string("sin tope") : to_string(tope)) << setw(12)
+         << t << setw(16) << resultado.alineamientos.size() << endl;
+  }
+}
+
+// Benchmark: top-k alineamientos no solapados entre dos secuencias con repeticiones sembradas, con
+// recalculo incremental y recalculando toda la matriz en cada paso
+void benchmarkTopK(int longitud, int k) {
+  mt19937 generador(31);
+  string s1 = generarSecuenciaAleatoria(longitud, generador);
+  string s2 = generarSecuenciaAleatoria(longitud, generador);
+  // Copias mutadas de tramos de s1 en posiciones al azar de s2
+  for (int r = 0; r < k; ++r) {
+    int largo = 30 + generador() % 70;
+    string copia = mutarSecuencia(s1.substr(generador() % (longitud - largo), largo), 0.1, generador);
+    s2.replace(generador() % (longitud - copia.length()), copia.length(), copia);
+  }
+  cout << "--- Benchmark top-k Waterman-Eggert (" << longitud << " x " << longitud << ", k = " << k << ") ---"
+       << endl;
+  vector<AlineamientoNoSolapado> incremental, completo;
+  double tIncremental = medirSegundos([&] { incremental = mejoresAlineamientosLocales(s1, s2, k); });
+  double tCompleto = medirSegundos([&] { completo = mejoresAlineamientosLocales(s1, s2, k, false); });
+  cout << "incremental: " << tIncremental << " s, recalculo completo: " << tCompleto << " s" << endl;
+  cout << "scores:";
+  for (const auto &hit : incremental)
+    cout << " " << hit.score;
+  cout << endl;
+  bool iguales = incremental.size() == completo.size();
+  for (size_t r = 0; iguales && r < incremental.size(); ++r)
+    iguales = incremental[r].score == completo[r].score && incremental[r].info.cigar == completo[r].info.cigar &&
+              incremental[r].info.start_s1 == completo[r].info.start_s1 &&
+              incremental[r].info.start_s2 == completo[r].info.start_s2;
+  if (!iguales)
+    cerr << "Error: el recalculo incremental no coincide con el completo" << endl;
+}
+
+// Benchmark: prefiltro de semilla y extension frente a Smith-Waterman exhaustivo (striped) sobre una base
+// aleatoria con homologos plantados de cada consulta a varias divergencias. Recall: fraccion de homologos
+// que el prefiltro encuentra (score > 0) y, entre ellos, cuantos con el mismo score que el exhaustivo.
+void benchmarkSemillas(int numObjetivos) {
+  mt19937 generador(31);
+  const int numConsultas = 20;
+  const double divergencias[] = {0.05, 0.1, 0.2, 0.3};
+  vector<string> consultas, base;
+  for (int q = 0; q < numConsultas; ++q)
+    consultas.push_back(generarSecuenciaAleatoria(300, generador));
+  for (int k = 0; k < numObjetivos; ++k)
+    base.push_back(generarSecuenciaAleatoria(200 + generador() % 401, generador));
+  // plantados[q][d]: objetivo con la copia de la consulta q a la divergencia d
+  vector<vector<int>> plantados(numConsultas);
+  for (int q = 0; q < numConsultas; ++q) {
+    for (double divergencia : divergencias) {
+      int k = generador() % numObjetivos;
+      base[k].insert(generador() % (base[k].length() + 1), mutarSecuencia(consultas[q], divergencia, generador));
+      plantados[q].push_back(k);
+    }
+  }
+  size_t bases = 0;
+  for (const auto &objetivo : base)
+    bases += objetivo.length();
+  cout << "--- Benchmark semilla y extension (" << numConsultas << " consultas de 300 x " << numObjetivos
+       << " objetivos, " << bases << " bases) ---" << endl;
+
+  vector<vector<MejorCeldaLocal>> exhaustivo(numConsultas);
+  double tExhaustivo = medirSegundos([&] {
+    for (int q = 0; q < numConsultas; ++q)
+      exhaustivo[q] = alineamientoLocalScoreLote<PuntuacionEstandar>(consultas[q], base);
+  });
+  cout << "exhaustivo (striped): " << tExhaustivo << " s" << endl;
+  // veces: aceleracion de las consultas sobre el exhaustivo, sin y con la construccion del indice
+  cout << setw(20) << "patron" << setw(8) << "indice" << setw(10) << "consultas" << setw(8) << "veces" << setw(8)
+       << "+indice" << setw(10) << "ext/cons" << setw(10) << "cand/cons";
+  for (double divergencia : divergencias)
+    cout << setw(7) << "r" + to_string((int)(100 * divergencia));
+  cout << setw(8) << "exacto" << endl;
+
+  auto medir = [&](OpcionesSemillas opciones) {
+    EstadisticasSemillas estadisticas;
+    vector<vector<MejorCeldaLocal>> prefiltro(numConsultas);
+    unique_ptr<IndiceSemillas> indice;
+    double tIndice = medirSegundos([&] { indice = make_unique<IndiceSemillas>(base, opciones); });
+    double tConsultas = medirSegundos([&] {
+      for (int q = 0; q < numConsultas; ++q)
+        prefiltro[q] =
+            alineamientoLocalSemillas<PuntuacionEstandar>(consultas[q], base, *indice, opciones, &estadisticas);
+    });
+    int encontrados[4] = {}, exactos = 0, totalEncontrados = 0;
+    for (int q = 0; q < numConsultas; ++q) {
+      for (int d = 0; d < 4; ++d) {
+        int k = plantados[q][d];
+        if (prefiltro[q][k].score > 0) {
+          ++encontrados[d];
+          ++totalEncontrados;
+          exactos += prefiltro[q][k].score == exhaustivo[q][k].score;
+        }
+        if (prefiltro[q][k].score > exhaustivo[q][k].score)
+          cerr << "Error: el prefiltro supera al score exhaustivo" << endl;
+      }
+    }
+    cout << setw(20) << opciones.patron << setw(8) << fixed << setprecision(3) << tIndice << setw(10) << tConsultas
+         << setw(8) << setprecision(0) << tExhaustivo / tConsultas << setw(8) << setprecision(1)
+         << tExhaustivo / (tIndice + tConsultas) << setw(10) << setprecision(0)
+         << (double)estadisticas.extensiones / numConsultas << setw(10)
+         << (double)estadisticas.candidatos / numConsultas << setprecision(2);
+    for (int d = 0; d < 4; ++d)
+      cout << setw(7) << (double)encontrados[d] / numConsultas;
+    cout << setw(8) << (totalEncontrados ? (double)exactos / totalEncontrados : 0.0) << defaultfloat << endl;
+  };
+  for (string patron : {"11111111111", "111010010100110111", "111111111", "11011011011", "111111111111"}) {
+    OpcionesSemillas opciones;
+    opciones.patron = patron;
+    medir(opciones);
+  }
+  // Sensibilidad al umbral de la extension sin gaps con la semilla por defecto
+  for (int umbral : {10, 20}) {
+    OpcionesSemillas opciones;
+    opciones.umbralSinGaps = umbral;
+    cout << "umbral sin gaps " << umbral << ":" << endl;
+    medir(opciones);
+  }
+}
+
+// Benchmark: repeticiones internas con el triangulo superior frente a la autocomparacion completa, que
+// necesita 2k + 1 alineamientos para dar las mismas k: el primero es la diagonal trivial y cada
+// repeticion aparece dos veces, en espejo
+void benchmarkRepeticiones(int longitud, int k) {
+  mt19937 generador(37);
+  string s = generarSecuenciaAleatoria(longitud, generador);
+  for (int r = 0; r < k; ++r) {
+    int largo = 30 + generador() % 70;
+    string copia = mutarSecuencia(s.substr(generador() % (longitud - largo), largo), 0.1, generador);
+    s.replace(generador() % (longitud - copia.length()), copia.length(), copia);
+  }
+  cout << "--- Benchmark repeticiones internas (longitud " << longitud << ", k = " << k << ") ---" << endl;
+  vector<AlineamientoNoSolapado> triangulo, completo;
+  double tTriangulo = medirSegundos([&] { triangulo = repeticionesInternas(s, k); });
+  double tCompleto = medirSegundos([&] { completo = mejoresAlineamientosLocales(s, s, 2 * k + 1); });
+  double celdas = (double)(longitud + 1) * (longitud + 1);
+  cout << setw(12) << "" << setw(10) << "segundos" << setw(12) << "matriz MB" << endl;
+  cout << setw(12) << "triangulo" << setw(10) << tTriangulo << setw(12) << celdas / 2 * 4.125 / 1e6 << endl;
+  cout << setw(12) << "completa" << setw(10) << tCompleto << setw(12) << celdas * 4.125 / 1e6 << endl;
+  // Cada repeticion del triangulo deberia estar en la autocomparacion completa, igual o en espejo
+  int encontradas = 0;
+  for (const auto &repeticion : triangulo) {
+    for (const auto &hit : completo) {
+      const AlineamientoInfo &a = repeticion.info, &b = hit.info;
+      if (hit.score == repeticion.score &&
+          ((a.start_s1 == b.start_s1 && a.start_s2 == b.start_s2) ||
+           (a.start_s1 == b.start_s2 && a.start_s2 == b.start_s1))) {
+        ++encontradas;
+        break;
+      }
+    }
+  }
+  cout << "repeticiones tambien en la autocomparacion completa: " << encontradas << " de " << triangulo.size() << endl;
+}
+
 // Función guardar resultados
-void guardarResultados(const string &nombreArchivo, const ResultadoAlineamientoLocal &resultado) {
+void guardarResultados(const string &nombreArchivo, const ResultadoAlineamientoLocal &resultado, const string &s1,
+                       const string &s2, const OpcionesMatriz &opcionesMatriz = OpcionesMatriz()) {
+  Rectangulo rectangulo = {0, 0, resultado.matrizScores.filas(), resultado.matrizScores.columnas()};
+  if (opcionesMatriz.margenCamino >= 0 && !resultado.alineamientos.empty()) {
+    const AlineamientoInfo &primero = resultado.alineamientos[0];
+    rectangulo = rectanguloCamino(primero.cigar, primero.start_s1, primero.start_s2, opcionesMatriz.margenCamino,
+                                  resultado.matrizScores);
+  }
+  if (!opcionesMatriz.archivoNpy.empty() && !resultado.matrizScores.vacia() &&
+      exportarMatrizNpy(opcionesMatriz.archivoNpy, resultado.matrizScores, rectangulo)) {
+    cout << "Matriz guardada en " << opcionesMatriz.archivoNpy << endl;
+  }
+
   ofstream archivoSalida(nombreArchivo);
   if (archivoSalida.is_open()) {
     archivoSalida << "* Score final(Optimo): " << resultado.scoreMayor << endl;
 
-    archivoSalida << "\n* Matriz:" << endl;
-    for (const auto &fila : resultado.matrizScores) {
-      for (size_t j = 0; j < fila.size(); ++j) {
-        archivoSalida << setw(4) << fila[j] << (j == fila.size() - 1 ? "" : "\t");
+    if (opcionesMatriz.texto) {
+      archivoSalida << "\n* Matriz:" << endl;
+      for (int i = rectangulo.fila; i < rectangulo.fila + rectangulo.filas; ++i) {
+        for (int j = rectangulo.columna; j < rectangulo.columna + rectangulo.columnas; ++j) {
+          archivoSalida << setw(4) << resultado.matrizScores(i, j)
+                        << (j == rectangulo.columna + rectangulo.columnas - 1 ? "" : "\t");
+        }
+        archivoSalida << endl;
       }
-      archivoSalida << endl;
     }
 
     archivoSalida << "\n* N de alineamientos optimos: " << resultado.alineamientos.size() << endl;
@@ -155,8 +1754,9 @@ void guardarResultados(const string &nombreArchivo, const ResultadoAlineamientoL
       const auto &info = resultado.alineamientos[k];
       archivoSalida << "\t*Alineamiento " << k + 1 << ":" << endl;
       // subsecuencia comun
-      archivoSalida << "\t\tS1: " << info.s1_alineada << endl;
-      archivoSalida << "\t\tS2: " << info.s2_alineada << endl;
+      pair<string, string> columnas = info.cigar.expandir(s1, s2, info.start_s1, info.start_s2);
+      archivoSalida << "\t\tS1: " << columnas.first << endl;
+      archivoSalida << "\t\tS2: " << columnas.second << endl;
       // posición donde se encuentran ambas cadenas
       archivoSalida << "\t\tS1_pos: [" << info.start_s1 << " - " << info.end_s1 << "]" << endl;
       archivoSalida << "\t\tS2_pos: [" << info.start_s2 << " - " << info.end_s2 << "]" << endl << endl;
@@ -169,26 +1769,397 @@ void guardarResultados(const string &nombreArchivo, const ResultadoAlineamientoL
   }
 }
 
-int main() {
+// Variante de cada familia de kernels elegida en esta maquina
+void imprimirDespachoSIMD() {
+  NivelSIMD enUso = nivelSIMD(); // antes de imprimir: puede avisar por cerr
+  cout << "SIMD soportado: " << nombreNivelSIMD(nivelSIMDSoportado()) << ", en uso: " << nombreNivelSIMD(enUso) << endl;
+  cout << "  Gotoh por antidiagonales:   " << (enUso >= NivelSIMD::AVX2 ? "avx2" : "escalar") << endl;
+  cout << "  Smith-Waterman solo score:  "
+       << (enUso >= NivelSIMD::AVX2 ? "striped avx2 (8 bits, rescate 16/32)" : "escalar") << endl;
+}
+
+// ===================================== Pruebas (./main test) =====================================
+// Cada kernel contra el Smith-Waterman de libro con matrices completas, sobre entradas aleatorias de
+// semilla fija y los bordes: secuencias vacias, de un caracter y de mas de 64 bases.
+
+// Politica con scores grandes para forzar los rescates: 8 bits no alcanzan ni para el perfil y 16 bits se
+// saturan con un par identico de unas 220 bases
+using PuntuacionPesada = PuntuacionLineal<300, -300, -600>;
+
+// Secuencia al azar sobre un alfabeto dado; los alfabetos chicos dan muchos empates
+static string secuenciaPrueba(int longitud, const string &alfabeto, mt19937 &generador) {
+  string sec(longitud, alfabeto[0]);
+  for (char &c : sec)
+    c = alfabeto[generador() % alfabeto.size()];
+  return sec;
+}
+
+// Smith-Waterman/Gotoh con las matrices completas (con gaps lineales apertura = 0 y E, F no cambian nada).
+// La mejor celda es la primera en orden de filas que alcanza el maximo.
+template <class P> static MejorCeldaLocal mejorCeldaLocalDirecta(const string &s1, const string &s2) {
+  int n = s1.length(), m = s2.length();
+  vector<vector<int>> H(n + 1, vector<int>(m + 1, 0)), E(n + 1, vector<int>(m + 1, MENOS_INFINITO)), F = E;
+  MejorCeldaLocal mejor = {0, 0, 0};
+  for (int i = 1; i <= n; ++i)
+    for (int j = 1; j <= m; ++j) {
+      E[i][j] = max(E[i - 1][j], H[i - 1][j] + P::apertura) + P::extension;
+      F[i][j] = max(F[i][j - 1], H[i][j - 1] + P::apertura) + P::extension;
+      H[i][j] = max({0, H[i - 1][j - 1] + P::sustitucion(s1[i - 1], s2[j - 1]), E[i][j], F[i][j]});
+      if (H[i][j] > mejor.score)
+        mejor = {H[i][j], i, j};
+    }
+  return mejor;
+}
+
+static bool operator==(const MejorCeldaLocal &a, const MejorCeldaLocal &b) {
+  return a.score == b.score && a.fila == b.fila && a.columna == b.columna;
+}
+
+// El cigar cubre exactamente s1[start_s1..end_s1] y s2[start_s2..end_s2], y sus '=' y 'X' son ciertos
+static bool cigarConsistente(const AlineamientoInfo &info, const string &s1, const string &s2) {
+  int i = info.start_s1, j = info.start_s2;
+  if (i < 0 || j < 0)
+    return false;
+  for (size_t k = 0; k < info.cigar.cantidadRachas(); ++k) {
+    char op = info.cigar.operacion(k);
+    for (uint32_t c = 0; c < info.cigar.longitud(k); ++c) {
+      if ((op != 'I' && i > info.end_s1) || (op != 'D' && j > info.end_s2))
+        return false;
+      if ((op == '=' && s1[i] != s2[j]) || (op == 'X' && s1[i] == s2[j]))
+        return false;
+      i += op != 'I';
+      j += op != 'D';
+    }
+  }
+  return i == info.end_s1 + 1 && j == info.end_s2 + 1 && info.end_s1 < (int)s1.length() &&
+         info.end_s2 < (int)s2.length();
+}
+
+// Pares de prueba: bordes fijos, pares parecidos (con un par identico largo) y pares sin relacion
+static vector<pair<string, string>> paresPrueba(mt19937 &generador) {
+  vector<pair<string, string>> pares = {{"", ""}, {"", "ACGT"}, {"GATTACA", ""}, {"A", "A"}, {"A", "C"},
+                                        {"A", generarSecuenciaAleatoria(100, generador)}};
+  for (int longitud : {15, 16, 17, 32, 33, 64, 65, 150})
+    for (double divergencia : {0.0, 0.1, 0.3}) {
+      string base = generarSecuenciaAleatoria(longitud, generador);
+      pares.push_back({base, mutarSecuencia(base, divergencia, generador)});
+    }
+  string largo = generarSecuenciaAleatoria(300, generador);
+  pares.push_back({largo, largo});
+  for (string alfabeto : {"A", "AC", "ACGT"})
+    for (int k = 0; k < 4; ++k)
+      pares.push_back({secuenciaPrueba(generador() % 120, alfabeto, generador),
+                       secuenciaPrueba(generador() % 120, alfabeto, generador)});
+  return pares;
+}
+
+template <class P> static void probarScoreLocal(const vector<pair<string, string>> &pares) {
+  for (const pair<string, string> &par : pares) {
+    const string &s1 = par.first, &s2 = par.second;
+    MejorCeldaLocal esperada = mejorCeldaLocalDirecta<P>(s1, s2);
+    CHECK(alineamientoLocalScoreEscalar<P>(s1, s2) == esperada);
+    CHECK(alineamientoLocalScore<P>(s1, s2) == esperada);
+    // Mismo par en ambos sentidos: el kernel transpone segun cual sea mas corta
+    MejorCeldaLocal inversa = mejorCeldaLocalDirecta<P>(s2, s1);
+    CHECK(alineamientoLocalScore<P>(s2, s1) == inversa);
+  }
+}
+
+TEST_CASE("Smith-Waterman striped (8, 16 y 32 bits) contra las matrices completas") {
+  mt19937 generador(201);
+  vector<pair<string, string>> pares = paresPrueba(generador);
+
+  SUBCASE("Un par a la vez") {
+    probarScoreLocal<PuntuacionEstandar>(pares);
+    probarScoreLocal<PuntuacionTransiciones>(pares);
+    probarScoreLocal<PuntuacionBlastn>(pares);
+    probarScoreLocal<PuntuacionPesada>(pares);
+    for (const pair<string, string> &par : pares)
+      CHECK(alineamientoLocalScoreParalelo(par.first, par.second, 3, 32) ==
+            mejorCeldaLocalDirecta<PuntuacionEstandar>(par.first, par.second));
+  }
+
+  // Una consulta contra todos los objetivos: el lote satura y rescata solo los pares que lo necesitan
+  SUBCASE("Lote con rescates") {
+    for (const string &consulta :
+         {string(), string("A"), pares.back().first, generarSecuenciaAleatoria(300, generador)}) {
+      vector<string> objetivos;
+      for (const pair<string, string> &par : pares)
+        objetivos.push_back(par.second);
+      objetivos.push_back(consulta);
+      EstadisticasRescate estandar, pesada;
+      vector<MejorCeldaLocal> mejores =
+          alineamientoLocalScoreLote<PuntuacionEstandar>(consulta, objetivos, &estandar);
+      vector<MejorCeldaLocal> mejoresPesada =
+          alineamientoLocalScoreLote<PuntuacionPesada>(consulta, objetivos, &pesada);
+      REQUIRE(mejores.size() == objetivos.size());
+      for (size_t k = 0; k < objetivos.size(); ++k) {
+        CHECK(mejores[k] == mejorCeldaLocalDirecta<PuntuacionEstandar>(consulta, objetivos[k]));
+        CHECK(mejoresPesada[k] == mejorCeldaLocalDirecta<PuntuacionPesada>(consulta, objetivos[k]));
+      }
+      CHECK(estandar.pares == objetivos.size());
+      // La consulta contra si misma puntua su longitud: con 300 bases satura 8 bits y, pesada, tambien 16
+      if (nivelSIMD() >= NivelSIMD::AVX2 && consulta.length() == 300) {
+        CHECK(estandar.rescates16 >= 1);
+        CHECK(pesada.rescates32 >= 1);
+      }
+    }
+  }
+}
+
+TEST_CASE("Alineamiento local con traceback contra las matrices completas") {
+  mt19937 generador(202);
+  for (const pair<string, string> &par : paresPrueba(generador)) {
+    const string &s1 = par.first, &s2 = par.second;
+    MejorCeldaLocal lineal = mejorCeldaLocalDirecta<PuntuacionEstandar>(s1, s2);
+    MejorCeldaLocal afin = mejorCeldaLocalDirecta<PuntuacionBlastn>(s1, s2);
+
+    ResultadoAlineamientoLocal completo = alineamientoLocal(s1, s2, false, 5);
+    CHECK(completo.scoreMayor == lineal.score);
+    CHECK(completo.alineamientos.empty() == (lineal.score == 0));
+    for (const AlineamientoInfo &info : completo.alineamientos) {
+      CHECK(cigarConsistente(info, s1, s2));
+      CHECK(puntuarCigar<PuntuacionEstandar>(info.cigar, s1, s2, info.start_s1, info.start_s2) == lineal.score);
+    }
+
+    // Un solo alineamiento, terminado en la primera celda optima en orden de filas
+    for (const auto &[resultado, esperada, afinado] :
+         {make_tuple(alineamientoLocalEspacioLineal<PuntuacionEstandar>(s1, s2), lineal, false),
+          make_tuple(alineamientoLocalAfin<PuntuacionBlastn>(s1, s2), afin, true)}) {
+      CHECK(resultado.scoreMayor == esperada.score);
+      REQUIRE(resultado.alineamientos.size() == (esperada.score > 0 ? 1u : 0u));
+      if (esperada.score == 0)
+        continue;
+      const AlineamientoInfo &info = resultado.alineamientos[0];
+      CHECK(info.end_s1 == esperada.fila - 1);
+      CHECK(info.end_s2 == esperada.columna - 1);
+      CHECK(cigarConsistente(info, s1, s2));
+      int score = afinado ? puntuarCigar<PuntuacionBlastn>(info.cigar, s1, s2, info.start_s1, info.start_s2)
+                          : puntuarCigar<PuntuacionEstandar>(info.cigar, s1, s2, info.start_s1, info.start_s2);
+      CHECK(score == esperada.score);
+    }
+  }
+}
+
+// Waterman-Eggert de libro: en cada paso recalcula la matriz completa con las celdas bloqueadas y hace el
+// traceback desde la primera celda maxima en orden de filas (diagonal, arriba, izquierda)
+template <class P>
+static vector<AlineamientoNoSolapado> watermanEggertDirecto(const string &s1, const string &s2, int k,
+                                                            int diagonalMin) {
+  int n = s1.length(), m = s2.length();
+  vector<vector<bool>> bloqueada(n + 1, vector<bool>(m + 1, false));
+  vector<AlineamientoNoSolapado> resultado;
+  while ((int)resultado.size() < k) {
+    vector<vector<int>> H(n + 1, vector<int>(m + 1, 0));
+    int mejor = 0, fila = 0, columna = 0;
+    for (int i = 1; i <= n; ++i)
+      for (int j = max(1, i + diagonalMin); j <= m; ++j) {
+        H[i][j] = max({0, H[i - 1][j] + P::extension, H[i][j - 1] + P::extension});
+        if (!bloqueada[i][j])
+          H[i][j] = max(H[i][j], H[i - 1][j - 1] + P::sustitucion(s1[i - 1], s2[j - 1]));
+        if (H[i][j] > mejor) {
+          mejor = H[i][j];
+          fila = i;
+          columna = j;
+        }
+      }
+    if (mejor == 0)
+      break;
+    AlineamientoNoSolapado hit;
+    hit.score = mejor;
+    hit.info.end_s1 = fila - 1;
+    hit.info.end_s2 = columna - 1;
+    int i = fila, j = columna;
+    while (H[i][j] > 0) {
+      if (!bloqueada[i][j] && H[i][j] == H[i - 1][j - 1] + P::sustitucion(s1[i - 1], s2[j - 1])) {
+        hit.info.cigar.agregarPar(s1[i - 1], s2[j - 1]);
+        bloqueada[i][j] = true;
+        --i;
+        --j;
+      } else if (H[i][j] == H[i - 1][j] + P::extension) {
+        hit.info.cigar.agregar('D');
+        --i;
+      } else {
+        hit.info.cigar.agregar('I');
+        --j;
+      }
+    }
+    hit.info.cigar.invertir();
+    hit.info.start_s1 = i;
+    hit.info.start_s2 = j;
+    resultado.push_back(hit);
+  }
+  return resultado;
+}
+
+static bool mismosAlineamientos(const vector<AlineamientoNoSolapado> &a, const vector<AlineamientoNoSolapado> &b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t k = 0; k < a.size(); ++k) {
+    const AlineamientoInfo &x = a[k].info, &y = b[k].info;
+    if (a[k].score != b[k].score || !(x.cigar == y.cigar) || x.start_s1 != y.start_s1 || x.end_s1 != y.end_s1 ||
+        x.start_s2 != y.start_s2 || x.end_s2 != y.end_s2)
+      return false;
+  }
+  return true;
+}
+
+TEST_CASE("Waterman-Eggert incremental contra el recalculo completo") {
+  mt19937 generador(203);
+  vector<string> secuencias = {"", "A", "AAAAAAAA", "ACACACACAC"};
+  for (string alfabeto : {"AC", "ACGT"})
+    for (int longitud : {2, 30, 65, 150}) {
+      string base = secuenciaPrueba(longitud, alfabeto, generador);
+      secuencias.push_back(base);
+      // Repeticiones internas: la misma base, una copia mutada y relleno al azar
+      secuencias.push_back(base + secuenciaPrueba(20, alfabeto, generador) + mutarSecuencia(base, 0.1, generador));
+    }
+
+  SUBCASE("Mejores alineamientos locales") {
+    for (size_t a = 0; a < secuencias.size(); ++a) {
+      const string &s1 = secuencias[a], &s2 = secuencias[(a * 7 + 3) % secuencias.size()];
+      for (int k : {1, 5, 12}) {
+        vector<AlineamientoNoSolapado> esperados =
+            watermanEggertDirecto<PuntuacionEstandar>(s1, s2, k, -(int)s1.length());
+        CHECK(mismosAlineamientos(mejoresAlineamientosLocales(s1, s2, k), esperados));
+        CHECK(mismosAlineamientos(mejoresAlineamientosLocales(s1, s2, k, false), esperados));
+        for (const AlineamientoNoSolapado &hit : esperados)
+          CHECK(cigarConsistente(hit.info, s1, s2));
+      }
+    }
+  }
+
+  SUBCASE("Repeticiones internas") {
+    for (const string &s : secuencias)
+      for (int k : {1, 5, 12}) {
+        vector<AlineamientoNoSolapado> esperados = watermanEggertDirecto<PuntuacionEstandar>(s, s, k, 1);
+        CHECK(mismosAlineamientos(repeticionesInternas(s, k), esperados));
+        CHECK(mismosAlineamientos(repeticionesInternas(s, k, false), esperados));
+        for (const AlineamientoNoSolapado &hit : esperados)
+          CHECK(hit.info.start_s2 > hit.info.start_s1);
+      }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // ./main test [opciones de doctest]: pruebas de los kernels contra implementaciones directas
+  if (argc > 1 && string(argv[1]) == "test") {
+    doctest::Context contexto(argc - 1, argv + 1);
+    return contexto.run();
+  }
+  // ./main simd: que variante de cada kernel se eligio (BIOINF_SIMD=escalar|avx2|avx512 la fuerza)
+  if (argc > 1 && string(argv[1]) == "simd") {
+    imprimirDespachoSIMD();
+    return 0;
+  }
+  // Busqueda en base de datos: ./main buscar consultas.fa base.fa [N=10] [hilos] [estandar|transiciones|blastn]
+  // (buscar-semillas: igual, con el prefiltro de semilla y extension)
+  if (argc > 3 && (string(argv[1]) == "buscar" || string(argv[1]) == "buscar-semillas")) {
+    OpcionesBusqueda opciones;
+    opciones.prefiltro = string(argv[1]) == "buscar-semillas";
+    opciones.maxAciertos = argc > 4 ? stoul(argv[4]) : 10;
+    opciones.numHilos = argc > 5 ? stoi(argv[5]) : max(1u, thread::hardware_concurrency());
+    string esquema = argc > 6 ? argv[6] : "estandar";
+    opciones.esquema = esquema == "transiciones" ? EsquemaPuntuacion::Transiciones
+                       : esquema == "blastn"     ? EsquemaPuntuacion::Blastn
+                                                 : EsquemaPuntuacion::Estandar;
+    LectorFasta lectorConsultas(argv[2]), base(argv[3]);
+    if (!lectorConsultas.abierto() || !base.abierto())
+      return 1;
+    vector<RegistroFasta> consultas;
+    RegistroFasta registro;
+    while (lectorConsultas.siguiente(registro))
+      consultas.push_back(registro);
+    size_t secuencias = 0, bases = 0;
+    vector<AciertoFinal> aciertos;
+    double segundos = medirSegundos([&] { aciertos = buscarEnBase(consultas, base, opciones, secuencias, bases); });
+    imprimirAciertos(cout, consultas, aciertos);
+    // El resumen va por cerr para no mezclarse con la tabla
+    cerr << consultas.size() << " consultas contra " << secuencias << " secuencias (" << bases << " bases) en "
+         << segundos << " s con " << opciones.numHilos << " hilos" << endl;
+    return 0;
+  }
+  // Modo benchmark: ./main bench-striped [longitud del objetivo]
+  if (argc > 1 && string(argv[1]) == "bench-striped") {
+    benchmarkStriped(argc > 2 ? stoi(argv[2]) : 1000000);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-rescate [objetivos]
+  if (argc > 1 && string(argv[1]) == "bench-rescate") {
+    benchmarkRescate(argc > 2 ? stoi(argv[2]) : 20000);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-espacio-lineal [longitud]
+  if (argc > 1 && string(argv[1]) == "bench-espacio-lineal") {
+    benchmarkEspacioLineal(argc > 2 ? stoi(argv[2]) : 20000);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-empates [longitud]
+  if (argc > 1 && string(argv[1]) == "bench-empates") {
+    benchmarkEmpates(argc > 2 ? stoi(argv[2]) : 2000);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-top-k [longitud] [k]
+  if (argc > 1 && string(argv[1]) == "bench-top-k") {
+    benchmarkTopK(argc > 2 ? stoi(argv[2]) : 3000, argc > 3 ? stoi(argv[3]) : 30);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-semillas [objetivos]
+  if (argc > 1 && string(argv[1]) == "bench-semillas") {
+    benchmarkSemillas(argc > 2 ? stoi(argv[2]) : 50000);
+    return 0;
+  }
+  // Repeticiones internas de cada secuencia de un FASTA: ./main repeticiones secuencias.fa [k=10]
+  if (argc > 2 && string(argv[1]) == "repeticiones") {
+    LectorFasta lector(argv[2]);
+    if (!lector.abierto())
+      return 1;
+    int k = argc > 3 ? stoi(argv[3]) : 10;
+    RegistroFasta registro;
+    cout << "# secuencia\tscore\tidentidad\tinicio_1\tfin_1\tinicio_2\tfin_2\tcigar" << endl;
+    while (lector.siguiente(registro))
+      imprimirRepeticiones(cout, registro.nombre, repeticionesInternas(registro.secuencia, k));
+    return 0;
+  }
+  // Modo benchmark: ./main bench-repeticiones [longitud] [k]
+  if (argc > 1 && string(argv[1]) == "bench-repeticiones") {
+    benchmarkRepeticiones(argc > 2 ? stoi(argv[2]) : 3000, argc > 3 ? stoi(argv[3]) : 20);
+    return 0;
+  }
+  // Modo benchmark: ./main bench-hilos [longitud]
+  if (argc > 1 && string(argv[1]) == "bench-hilos") {
+    benchmarkHilos(argc > 2 ? stoi(argv[2]) : 20000);
+    return 0;
+  }
+
   cout << "--- Alineamiento Local (Smith-Waterman) ---" << endl;
+  // La matriz se escribe en texto dentro de cada archivo de resultados
+  OpcionesMatriz matrizEnTexto;
+  matrizEnTexto.texto = true;
 
   string sec1 = "AGCT";
   string sec2 = "GCA";
   cout << "\nProcesando S1: " << sec1 << " y S2: " << sec2 << endl;
-  ResultadoAlineamientoLocal res1 = alineamientoLocal(sec1, sec2);
-  guardarResultados("resultado_alineamiento_1.txt", res1);
+  ResultadoAlineamientoLocal res1 = alineamientoLocal(sec1, sec2, true);
+  guardarResultados("resultado_alineamiento_1.txt", res1, sec1, sec2, matrizEnTexto);
 
   string sec3 = "CCCGGGTTTAAA";
   string sec4 = "TTTGGGCCCAAA";
   cout << "\nProcesando S3: " << sec3 << " y S4: " << sec4 << endl;
-  ResultadoAlineamientoLocal res2 = alineamientoLocal(sec3, sec4);
-  guardarResultados("resultado_alineamiento_2.txt", res2);
+  ResultadoAlineamientoLocal res2 = alineamientoLocal(sec3, sec4, true);
+  guardarResultados("resultado_alineamiento_2.txt", res2, sec3, sec4, matrizEnTexto);
 
   string sec5 = "GGTTGACTA";
   string sec6 = "TGTTAGGG";
   cout << "\nProcesando S5: " << sec5 << " y S6: " << sec6 << endl;
-  ResultadoAlineamientoLocal res3 = alineamientoLocal(sec5, sec6);
-  guardarResultados("resultado_alineamiento_3.txt", res3);
+  ResultadoAlineamientoLocal res3 = alineamientoLocal(sec5, sec6, true);
+  guardarResultados("resultado_alineamiento_3.txt", res3, sec5, sec6, matrizEnTexto);
+  // Volcado binario solo del rectangulo que rodea el primer alineamiento (una celda de margen)
+  if (!res3.alineamientos.empty()) {
+    const AlineamientoInfo &primero = res3.alineamientos[0];
+    exportarMatrizNpy("resultado_alineamiento_3_matriz.npy", res3.matrizScores,
+                      rectanguloCamino(primero.cigar, primero.start_s1, primero.start_s2, 1, res3.matrizScores));
+  }
 
   return 0;
 }
@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -6,88 +8,239 @@
 #include <string>
 #include <vector>
 
-using namespace std;
+#include "../comun/alineamiento.h"
 
-// Params alineamiento global
-const int MATCH = 1;
-const int MISMATCH = -1;
-const int GAP = -2;
+using namespace std;
 
 // Estructura para el resultado de un alineamiento par-a-par global
 struct ResultadoAlineamientoPar {
-  string sec1Alineada;
-  string sec2Alineada;
+  Cigar cigar; // sec1 frente a sec2; expandir(sec1, sec2) da las cadenas con gaps
   int score;
 };
 
-// Implementacion alineamiento global
+// Implementacion alineamiento global (filas de scores rotativas + traceback compacto) con la politica P.
+// Con gaps afines se usa el kernel en memoria lineal del nucleo compartido (Gotoh + Myers-Miller).
+template <class P = PuntuacionEstandar>
 ResultadoAlineamientoPar alineamientoGlobalPar(const string &sec1, const string &sec2) {
+  if constexpr (P::esAfin) {
+    ResultadoAlineamientoPar res;
+    hirschbergAfin<P>(sec1.data(), sec1.length(), sec2.data(), sec2.length(), P::apertura, P::apertura, res.cigar);
+    res.score = puntuarCigar<P>(res.cigar, sec1, sec2);
+    return res;
+  }
   int longitud1 = sec1.length();
   int longitud2 = sec2.length();
-  vector<vector<int>> matriz(longitud1 + 1, vector<int>(longitud2 + 1));
+  MatrizTraceback traceback(longitud1, longitud2);
+  vector<int> anterior(longitud2 + 1), actual(longitud2 + 1);
 
-  for (int i = 0; i <= longitud1; ++i)
-    matriz[i][0] = i * GAP;
   for (int j = 0; j <= longitud2; ++j)
-    matriz[0][j] = j * GAP;
+    anterior[j] = j * P::extension;
 
   for (int i = 1; i <= longitud1; ++i) {
+    actual[0] = i * P::extension;
     for (int j = 1; j <= longitud2; ++j) {
-      int sumaResta = (sec1[i - 1] == sec2[j - 1] ? MATCH : MISMATCH);
-      int scoreDiagonal = matriz[i - 1][j - 1] + sumaResta;
-      int scoreArriba = matriz[i - 1][j] + GAP;
-      int scoreIzquierda = matriz[i][j - 1] + GAP;
-      matriz[i][j] = max({scoreDiagonal, scoreArriba, scoreIzquierda});
+      int sumaResta = P::sustitucion(sec1[i - 1], sec2[j - 1]);
+      int scoreDiagonal = anterior[j - 1] + sumaResta;
+      int scoreArriba = anterior[j] + P::extension;
+      int scoreIzquierda = actual[j - 1] + P::extension;
+      actual[j] = max({scoreDiagonal, scoreArriba, scoreIzquierda});
+      traceback.marcar(i, j,
+                       (scoreDiagonal == actual[j] ? MatrizTraceback::DIAGONAL : 0) |
+                           (scoreArriba == actual[j] ? MatrizTraceback::ARRIBA : 0) |
+                           (scoreIzquierda == actual[j] ? MatrizTraceback::IZQUIERDA : 0));
     }
+    swap(anterior, actual);
   }
 
   ResultadoAlineamientoPar res;
-  res.score = matriz[longitud1][longitud2];
-  string alineado1_rev = "", alineado2_rev = "";
+  res.score = anterior[longitud2];
   int i = longitud1, j = longitud2;
 
   while (i > 0 || j > 0) {
+    uint8_t direcciones = traceback.direcciones(i, j);
     // Caso Diagonal
-    if (i > 0 && j > 0 && matriz[i][j] == matriz[i - 1][j - 1] + (sec1[i - 1] == sec2[j - 1] ? MATCH : MISMATCH)) {
-      alineado1_rev += sec1[i - 1];
-      alineado2_rev += sec2[j - 1];
+    if (direcciones & MatrizTraceback::DIAGONAL) {
+      res.cigar.agregarPar(sec1[i - 1], sec2[j - 1]);
       i--;
       j--;
     }
-    // Caso arriba
-    else if (i > 0 && matriz[i][j] == matriz[i - 1][j] + GAP) {
-      alineado1_rev += sec1[i - 1];
-      alineado2_rev += '-';
+    // Caso arriba (incluye la columna 0, cuando sec2 ya se acabo)
+    else if (direcciones & MatrizTraceback::ARRIBA) {
+      res.cigar.agregar('D');
       i--;
     }
-    // Caso izquierda
-    else if (j > 0 && matriz[i][j] == matriz[i][j - 1] + GAP) {
-      alineado1_rev += '-';
-      alineado2_rev += sec2[j - 1];
+    // Caso izquierda (incluye la fila 0, cuando sec1 ya se acabo)
+    else {
+      res.cigar.agregar('I');
       j--;
     }
-    // Caso limite cuando una sec se acaba antes
-    else {
-      if (i > 0) {
-        alineado1_rev += sec1[i - 1];
-        alineado2_rev += '-';
-        i--;
-      } else if (j > 0) {
-        alineado1_rev += '-';
-        alineado2_rev += sec2[j - 1];
-        j--;
-      } else { // Ambos i y j son 0
-        break;
+  }
+  res.cigar.invertir();
+  return res;
+}
+
+// Matriz de sustitucion para proteinas con gap lineal. Las filas y columnas siguen ORDEN_RESIDUOS;
+// cualquier caracter fuera de ese alfabeto se puntua como X.
+const string ORDEN_RESIDUOS = "ARNDCQEGHILKMFPSTWYVBZX*";
+const int NUM_RESIDUOS = 24;
+
+struct MatrizSustitucion {
+  string nombre;
+  int gap;
+  int valores[NUM_RESIDUOS][NUM_RESIDUOS];
+};
+
+const MatrizSustitucion BLOSUM62 = {"BLOSUM62",
+                                    -4,
+                                    {
+     {  4,  -1,  -2,  -2,   0,  -1,  -1,   0,  -2,  -1,  -1,  -1,  -1,  -2,  -1,   1,   0,  -3,  -2,   0,  -2,  -1,   0,  -4},
+     { -1,   5,   0,  -2,  -3,   1,   0,  -2,   0,  -3,  -2,   2,  -1,  -3,  -2,  -1,  -1,  -3,  -2,  -3,  -1,   0,  -1,  -4},
+     { -2,   0,   6,   1,  -3,   0,   0,   0,   1,  -3,  -3,   0,  -2,  -3,  -2,   1,   0,  -4,  -2,  -3,   3,   0,  -1,  -4},
+     { -2,  -2,   1,   6,  -3,   0,   2,  -1,  -1,  -3,  -4,  -1,  -3,  -3,  -1,   0,  -1,  -4,  -3,  -3,   4,   1,  -1,  -4},
+     {  0,  -3,  -3,  -3,   9,  -3,  -4,  -3,  -3,  -1,  -1,  -3,  -1,  -2,  -3,  -1,  -1,  -2,  -2,  -1,  -3,  -3,  -2,  -4},
+     { -1,   1,   0,   0,  -3,   5,   2,  -2,   0,  -3,  -2,   1,   0,  -3,  -1,   0,  -1,  -2,  -1,  -2,   0,   3,  -1,  -4},
+     { -1,   0,   0,   2,  -4,   2,   5,  -2,   0,  -3,  -3,   1,  -2,  -3,  -1,   0,  -1,  -3,  -2,  -2,   1,   4,  -1,  -4},
+     {  0,  -2,   0,  -1,  -3,  -2,  -2,   6,  -2,  -4,  -4,  -2,  -3,  -3,  -2,   0,  -2,  -2,  -3,  -3,  -1,  -2,  -1,  -4},
+     { -2,   0,   1,  -1,  -3,   0,   0,  -2,   8,  -3,  -3,  -1,  -2,  -1,  -2,  -1,  -2,  -2,   2,  -3,   0,   0,  -1,  -4},
+     { -1,  -3,  -3,  -3,  -1,  -3,  -3,  -4,  -3,   4,   2,  -3,   1,   0,  -3,  -2,  -1,  -3,  -1,   3,  -3,  -3,  -1,  -4},
+     { -1,  -2,  -3,  -4,  -1,  -2,  -3,  -4,  -3,   2,   4,  -2,   2,   0,  -3,  -2,  -1,  -2,  -1,   1,  -4,  -3,  -1,  -4},
+     { -1,   2,   0,  -1,  -3,   1,   1,  -2,  -1,  -3,  -2,   5,  -1,  -3,  -1,   0,  -1,  -3,  -2,  -2,   0,   1,  -1,  -4},
+     { -1,  -1,  -2,  -3,  -1,   0,  -2,  -3,  -2,   1,   2,  -1,   5,   0,  -2,  -1,  -1,  -1,  -1,   1,  -3,  -1,  -1,  -4},
+     { -2,  -3,  -3,  -3,  -2,  -3,  -3,  -3,  -1,   0,   0,  -3,   0,   6,  -4,  -2,  -2,   1,   3,  -1,  -3,  -3,  -1,  -4},
+     { -1,  -2,  -2,  -1,  -3,  -1,  -1,  -2,  -2,  -3,  -3,  -1,  -2,  -4,   7,  -1,  -1,  -4,  -3,  -2,  -2,  -1,  -2,  -4},
+     {  1,  -1,   1,   0,  -1,   0,   0,   0,  -1,  -2,  -2,   0,  -1,  -2,  -1,   4,   1,  -3,  -2,  -2,   0,   0,   0,  -4},
+     {  0,  -1,   0,  -1,  -1,  -1,  -1,  -2,  -2,  -1,  -1,  -1,  -1,  -2,  -1,   1,   5,  -2,  -2,   0,  -1,  -1,   0,  -4},
+     { -3,  -3,  -4,  -4,  -2,  -2,  -3,  -2,  -2,  -3,  -2,  -3,  -1,   1,  -4,  -3,  -2,  11,   2,  -3,  -4,  -3,  -2,  -4},
+     { -2,  -2,  -2,  -3,  -2,  -1,  -2,  -3,   2,  -1,  -1,  -2,  -1,   3,  -3,  -2,  -2,   2,   7,  -1,  -3,  -2,  -1,  -4},
+     {  0,  -3,  -3,  -3,  -1,  -2,  -2,  -3,  -3,   3,   1,  -2,   1,  -1,  -2,  -2,   0,  -3,  -1,   4,  -3,  -2,  -1,  -4},
+     { -2,  -1,   3,   4,  -3,   0,   1,  -1,   0,  -3,  -4,   0,  -3,  -3,  -2,   0,  -1,  -4,  -3,  -3,   4,   1,  -1,  -4},
+     { -1,   0,   0,   1,  -3,   3,   4,  -2,   0,  -3,  -3,   1,  -1,  -3,  -1,   0,  -1,  -3,  -2,  -2,   1,   4,  -1,  -4},
+     {  0,  -1,  -1,  -1,  -2,  -1,  -1,  -1,  -1,  -1,  -1,  -1,  -1,  -1,  -2,   0,   0,  -2,  -1,  -1,  -1,  -1,  -1,  -4},
+     { -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,  -4,   1}}};
+
+const MatrizSustitucion PAM250 = {"PAM250",
+                                  -8,
+                                  {
+     {  2,  -2,   0,   0,  -2,   0,   0,   1,  -1,  -1,  -2,  -1,  -1,  -3,   1,   1,   1,  -6,  -3,   0,   0,   0,   0,  -8},
+     { -2,   6,   0,  -1,  -4,   1,  -1,  -3,   2,  -2,  -3,   3,   0,  -4,   0,   0,  -1,   2,  -4,  -2,  -1,   0,  -1,  -8},
+     {  0,   0,   2,   2,  -4,   1,   1,   0,   2,  -2,  -3,   1,  -2,  -3,   0,   1,   0,  -4,  -2,  -2,   2,   1,   0,  -8},
+     {  0,  -1,   2,   4,  -5,   2,   3,   1,   1,  -2,  -4,   0,  -3,  -6,  -1,   0,   0,  -7,  -4,  -2,   3,   3,  -1,  -8},
+     { -2,  -4,  -4,  -5,  12,  -5,  -5,  -3,  -3,  -2,  -6,  -5,  -5,  -4,  -3,   0,  -2,  -8,   0,  -2,  -4,  -5,  -3,  -8},
+     {  0,   1,   1,   2,  -5,   4,   2,  -1,   3,  -2,  -2,   1,  -1,  -5,   0,  -1,  -1,  -5,  -4,  -2,   1,   3,  -1,  -8},
+     {  0,  -1,   1,   3,  -5,   2,   4,   0,   1,  -2,  -3,   0,  -2,  -5,  -1,   0,   0,  -7,  -4,  -2,   3,   3,  -1,  -8},
+     {  1,  -3,   0,   1,  -3,  -1,   0,   5,  -2,  -3,  -4,  -2,  -3,  -5,   0,   1,   0,  -7,  -5,  -1,   0,   0,  -1,  -8},
+     { -1,   2,   2,   1,  -3,   3,   1,  -2,   6,  -2,  -2,   0,  -2,  -2,   0,  -1,  -1,  -3,   0,  -2,   1,   2,  -1,  -8},
+     { -1,  -2,  -2,  -2,  -2,  -2,  -2,  -3,  -2,   5,   2,  -2,   2,   1,  -2,  -1,   0,  -5,  -1,   4,  -2,  -2,  -1,  -8},
+     { -2,  -3,  -3,  -4,  -6,  -2,  -3,  -4,  -2,   2,   6,  -3,   4,   2,  -3,  -3,  -2,  -2,  -1,   2,  -3,  -3,  -1,  -8},
+     { -1,   3,   1,   0,  -5,   1,   0,  -2,   0,  -2,  -3,   5,   0,  -5,  -1,   0,   0,  -3,  -4,  -2,   1,   0,  -1,  -8},
+     { -1,   0,  -2,  -3,  -5,  -1,  -2,  -3,  -2,   2,   4,   0,   6,   0,  -2,  -2,  -1,  -4,  -2,   2,  -2,  -2,  -1,  -8},
+     { -3,  -4,  -3,  -6,  -4,  -5,  -5,  -5,  -2,   1,   2,  -5,   0,   9,  -5,  -3,  -3,   0,   7,  -1,  -4,  -5,  -2,  -8},
+     {  1,   0,   0,  -1,  -3,   0,  -1,   0,   0,  -2,  -3,  -1,  -2,  -5,   6,   1,   0,  -6,  -5,  -1,  -1,   0,  -1,  -8},
+     {  1,   0,   1,   0,   0,  -1,   0,   1,  -1,  -1,  -3,   0,  -2,  -3,   1,   2,   1,  -2,  -3,  -1,   0,   0,   0,  -8},
+     {  1,  -1,   0,   0,  -2,  -1,   0,   0,  -1,   0,  -2,   0,  -1,  -3,   0,   1,   3,  -5,  -3,   0,   0,  -1,   0,  -8},
+     { -6,   2,  -4,  -7,  -8,  -5,  -7,  -7,  -3,  -5,  -2,  -3,  -4,   0,  -6,  -2,  -5,  17,   0,  -6,  -5,  -6,  -4,  -8},
+     { -3,  -4,  -2,  -4,   0,  -4,  -4,  -5,   0,  -1,  -1,  -4,  -2,   7,  -5,  -3,  -3,   0,  10,  -2,  -3,  -4,  -2,  -8},
+     {  0,  -2,  -2,  -2,  -2,  -2,  -2,  -1,  -2,   4,   2,  -2,   2,  -1,  -1,  -1,   0,  -6,  -2,   4,  -2,  -2,  -1,  -8},
+     {  0,  -1,   2,   3,  -4,   1,   3,   0,   1,  -2,  -3,   1,  -2,  -4,  -1,   0,   0,  -5,  -3,  -2,   3,   2,  -1,  -8},
+     {  0,   0,   1,   3,  -5,   3,   3,   0,   2,  -2,  -3,   0,  -2,  -5,   0,   0,  -1,  -6,  -4,  -2,   2,   3,  -1,  -8},
+     {  0,  -1,   0,  -1,  -3,  -1,  -1,  -1,  -1,  -1,  -1,  -1,  -1,  -2,  -1,   0,   0,  -4,  -2,  -1,  -1,  -1,  -1,  -8},
+     { -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,  -8,   1}}};
+
+// Codigo (fila de la matriz) de un residuo
+int codigoResiduo(char residuo) {
+  size_t posicion = ORDEN_RESIDUOS.find(toupper(residuo));
+  return posicion == string::npos ? ORDEN_RESIDUOS.find('X') : posicion;
+}
+
+// Perfil de consulta: para cada residuo posible, la fila contigua de scores contra todas las posiciones
+// de la consulta. Se construye una sola vez por consulta y el lazo interno del DP lee
+// perfil[residuo objetivo][j] en vez de matriz[c1][c2].
+class PerfilConsulta {
+public:
+  PerfilConsulta(const string &consulta, const MatrizSustitucion &matriz)
+      : consulta(consulta), gap(matriz.gap), ancho(consulta.length()), puntajes((size_t)NUM_RESIDUOS * ancho, 0) {
+    for (int r = 0; r < NUM_RESIDUOS; ++r) {
+      for (size_t j = 0; j < consulta.length(); ++j) {
+        puntajes[(size_t)r * ancho + j] = matriz.valores[r][codigoResiduo(consulta[j])];
       }
     }
   }
-  reverse(alineado1_rev.begin(), alineado1_rev.end());
-  reverse(alineado2_rev.begin(), alineado2_rev.end());
-  res.sec1Alineada = alineado1_rev;
-  res.sec2Alineada = alineado2_rev;
+
+  // Con la consulta vacia la fila es vacia (puntajes no tiene elementos)
+  const int16_t *fila(char residuo) const { return puntajes.data() + (size_t)codigoResiduo(residuo) * ancho; }
+
+  const string consulta;
+  const int gap;
+
+private:
+  size_t ancho;
+  vector<int16_t> puntajes;
+};
+
+// Alineamiento global de la consulta del perfil contra un objetivo. Las filas del DP recorren el objetivo
+// y las columnas la consulta, para leer una fila contigua del perfil por cada residuo del objetivo.
+ResultadoAlineamientoPar alineamientoGlobalPerfil(const PerfilConsulta &perfil, const string &objetivo) {
+  const string &consulta = perfil.consulta;
+  int n = objetivo.length();
+  int m = consulta.length();
+  MatrizTraceback traceback(n, m);
+  vector<int> anterior(m + 1), actual(m + 1);
+
+  for (int j = 0; j <= m; ++j)
+    anterior[j] = j * perfil.gap;
+
+  for (int i = 1; i <= n; ++i) {
+    const int16_t *puntajes = perfil.fila(objetivo[i - 1]);
+    actual[0] = i * perfil.gap;
+    for (int j = 1; j <= m; ++j) {
+      int scoreDiagonal = anterior[j - 1] + puntajes[j - 1];
+      int scoreArriba = anterior[j] + perfil.gap;
+      int scoreIzquierda = actual[j - 1] + perfil.gap;
+      actual[j] = max({scoreDiagonal, scoreArriba, scoreIzquierda});
+      traceback.marcar(i, j,
+                       (scoreDiagonal == actual[j] ? MatrizTraceback::DIAGONAL : 0) |
+                           (scoreArriba == actual[j] ? MatrizTraceback::ARRIBA : 0) |
+                           (scoreIzquierda == actual[j] ? MatrizTraceback::IZQUIERDA : 0));
+    }
+    swap(anterior, actual);
+  }
+
+  ResultadoAlineamientoPar res;
+  res.score = anterior[m];
+  int i = n, j = m;
+  while (i > 0 || j > 0) {
+    uint8_t direcciones = traceback.direcciones(i, j);
+    if (direcciones & MatrizTraceback::DIAGONAL) {
+      res.cigar.agregarPar(consulta[--j], objetivo[--i]);
+    } else if (direcciones & MatrizTraceback::ARRIBA) {
+      // Residuo del objetivo frente a un gap en la consulta
+      res.cigar.agregar('I');
+      --i;
+    } else {
+      res.cigar.agregar('D');
+      --j;
+    }
+  }
+  res.cigar.invertir();
   return res;
 }
 
+// Score del alineamiento local (Smith-Waterman) de la consulta del perfil contra un objetivo
+int alineamientoLocalPerfil(const PerfilConsulta &perfil, const string &objetivo) {
+  int m = perfil.consulta.length();
+  vector<int> anterior(m + 1, 0), actual(m + 1, 0);
+  int scoreMayor = 0;
+  for (char residuo : objetivo) {
+    const int16_t *puntajes = perfil.fila(residuo);
+    for (int j = 1; j <= m; ++j) {
+      actual[j] = max({0, anterior[j - 1] + puntajes[j - 1], anterior[j] + perfil.gap, actual[j - 1] + perfil.gap});
+      scoreMayor = max(scoreMayor, actual[j]);
+    }
+    swap(anterior, actual);
+  }
+  return scoreMayor;
+}
+
 // Estructura para el resultado del Alineamiento Estrella
 struct ResultadoAlineamientoEstrella {
   vector<vector<int>> matrizScores;
@@ -96,8 +249,10 @@ struct ResultadoAlineamientoEstrella {
   vector<string> alineamientoMultiple;
 };
 
-// Implementación del Alineamiento Estrella
-ResultadoAlineamientoEstrella alineamientoEstrella(const vector<string> &secs) {
+// Implementación del Alineamiento Estrella. alinear(i, j) devuelve el alineamiento global de secs[i]
+// (como sec1 del CIGAR) con secs[j] (como sec2).
+template <class AlinearPar>
+ResultadoAlineamientoEstrella construirEstrella(const vector<string> &secs, AlinearPar alinear) {
   ResultadoAlineamientoEstrella resultado;
   int numsecs = secs.size();
 
@@ -116,7 +271,7 @@ ResultadoAlineamientoEstrella alineamientoEstrella(const vector<string> &secs) {
   for (int i = 0; i < numsecs; ++i) {
     for (int j = i + 1; j < numsecs; ++j) {
       // Realizamos un alineamiento global entre las secuencias i y j
-      ResultadoAlineamientoPar resAlineamiento = alineamientoGlobalPar(secs[i], secs[j]);
+      ResultadoAlineamientoPar resAlineamiento = alinear(i, j);
       // Guardamos el score en la matriz de scores, que es simétrica
       resultado.matrizScores[i][j] = resultado.matrizScores[j][i] = resAlineamiento.score;
       // Sumamos los scores de cada secuencia para determinar cuál tendrá la mayor relación con las otras
@@ -147,11 +302,16 @@ ResultadoAlineamientoEstrella alineamientoEstrella(const vector<string> &secs) {
       // Guardamos los alineamientos de las secuencias con la secuencia estrella
       mapaIndiceOriginalAIndiceAlineamientoParApar[i] = resultado.alineamientosConEstrella.size();
       // Realizamos un alineamiento global entre la secuencia estrella y la secuencia i
-      resultado.alineamientosConEstrella.push_back(alineamientoGlobalPar(secCentralOriginalStr, secs[i]));
+      resultado.alineamientosConEstrella.push_back(alinear(resultado.indiceSecCentralOriginal, i));
     }
   }
 
-  // 4. Construir Alineamiento Múltiple (MSA)
+  // 4. Construir Alineamiento Múltiple (MSA) a partir de las columnas con gaps de cada CIGAR
+  vector<pair<string, string>> columnasConEstrella(resultado.alineamientosConEstrella.size());
+  for (auto const &[indiceOriginal, indiceAlineamiento] : mapaIndiceOriginalAIndiceAlineamientoParApar) {
+    const Cigar &cigar = resultado.alineamientosConEstrella[indiceAlineamiento].cigar;
+    columnasConEstrella[indiceAlineamiento] = cigar.expandir(secCentralOriginalStr, secs[indiceOriginal]);
+  }
   vector<string> filasMSAFinal(numsecs);
   vector<int> punterosAlineamientoParApar(numsecs, 0);
   int punteroSecCentralOriginal = 0;
@@ -162,7 +322,7 @@ ResultadoAlineamientoEstrella alineamientoEstrella(const vector<string> &secs) {
     bool todosLosAlineamientosTerminados = true;
     for (auto const &[indiceOriginal, indiceAlineamiento] : mapaIndiceOriginalAIndiceAlineamientoParApar) {
       if (punterosAlineamientoParApar[indiceOriginal] <
-          resultado.alineamientosConEstrella[indiceAlineamiento].sec1Alineada.length()) {
+          columnasConEstrella[indiceAlineamiento].first.length()) {
         todosLosAlineamientosTerminados = false;
         break;
       }
@@ -173,15 +333,15 @@ ResultadoAlineamientoEstrella alineamientoEstrella(const vector<string> &secs) {
     // Paso 1: Buscar si alguna secuencia tiene una inserción en la posición actual
     bool insercionProcesada = false;
     for (auto const &[indiceOriginal, indiceAlineamiento] : mapaIndiceOriginalAIndiceAlineamientoParApar) {
-      const auto &alineamiento = resultado.alineamientosConEstrella[indiceAlineamiento];
+      const auto &alineamiento = columnasConEstrella[indiceAlineamiento];
       int &punteroActual = punterosAlineamientoParApar[indiceOriginal];
 
-      if (punteroActual < alineamiento.sec1Alineada.length() && alineamiento.sec1Alineada[punteroActual] == '-') {
+      if (punteroActual < alineamiento.first.length() && alineamiento.first[punteroActual] == '-') {
         insercionProcesada = true;
         // La secuencia 'indiceOriginal' tiene una inserción. Crear una columna en el MSA.
         for (int i = 0; i < numsecs; ++i) {
           if (i == indiceOriginal) {
-            filasMSAFinal[i] += alineamiento.sec2Alineada[punteroActual];
+            filasMSAFinal[i] += alineamiento.second[punteroActual];
           } else {
             filasMSAFinal[i] += '-';
           }
@@ -197,11 +357,11 @@ ResultadoAlineamientoEstrella alineamientoEstrella(const vector<string> &secs) {
     filasMSAFinal[resultado.indiceSecCentralOriginal] += secCentralOriginalStr[punteroSecCentralOriginal];
 
     for (auto const &[indiceOriginal, indiceAlineamiento] : mapaIndiceOriginalAIndiceAlineamientoParApar) {
-      const auto &alineamiento = resultado.alineamientosConEstrella[indiceAlineamiento];
+      const auto &alineamiento = columnasConEstrella[indiceAlineamiento];
       int &punteroActual = punterosAlineamientoParApar[indiceOriginal];
 
-      if (punteroActual < alineamiento.sec2Alineada.length()) {
-        filasMSAFinal[indiceOriginal] += alineamiento.sec2Alineada[punteroActual];
+      if (punteroActual < alineamiento.second.length()) {
+        filasMSAFinal[indiceOriginal] += alineamiento.second[punteroActual];
       } else {
         filasMSAFinal[indiceOriginal] += '-';
       }
@@ -214,6 +374,65 @@ ResultadoAlineamientoEstrella alineamientoEstrella(const vector<string> &secs) {
   return resultado;
 }
 
+// Alineamiento Estrella con la politica de puntuacion P
+template <class P = PuntuacionEstandar> ResultadoAlineamientoEstrella alineamientoEstrella(const vector<string> &secs) {
+  return construirEstrella(secs, [&](int i, int j) { return alineamientoGlobalPar<P>(secs[i], secs[j]); });
+}
+
+// Alineamiento Estrella de proteinas con una matriz de sustitucion: cada secuencia construye su perfil
+// de consulta una sola vez y lo reutiliza contra todas las demas.
+ResultadoAlineamientoEstrella alineamientoEstrella(const vector<string> &secs, const MatrizSustitucion &matriz) {
+  vector<PerfilConsulta> perfiles;
+  for (const auto &sec : secs)
+    perfiles.emplace_back(sec, matriz);
+  return construirEstrella(secs, [&](int i, int j) { return alineamientoGlobalPerfil(perfiles[i], secs[j]); });
+}
+
+// Scores locales (Smith-Waterman) de todos los pares con una matriz de sustitucion, reutilizando el
+// perfil de cada secuencia contra todas las demas
+vector<vector<int>> matrizScoresLocales(const vector<string> &secs, const MatrizSustitucion &matriz) {
+  vector<vector<int>> scores(secs.size(), vector<int>(secs.size(), 0));
+  for (size_t i = 0; i < secs.size(); ++i) {
+    PerfilConsulta perfil(secs[i], matriz);
+    for (size_t j = 0; j < secs.size(); ++j)
+      scores[i][j] = alineamientoLocalPerfil(perfil, secs[j]);
+  }
+  return scores;
+}
+
+// Guarda las matrices de scores locales de varias matrices de sustitucion en un archivo
+void guardarScoresLocales(const string &nombreArchivo, const vector<string> &secs,
+                          const vector<const MatrizSustitucion *> &matrices) {
+  ofstream archivoSalida(nombreArchivo);
+  if (!archivoSalida.is_open()) {
+    cerr << "Error al abrir el archivo " << nombreArchivo << endl;
+    return;
+  }
+  for (const MatrizSustitucion *matriz : matrices) {
+    archivoSalida << "* Matriz de scores locales (" << matriz->nombre << ", gap " << matriz->gap << "):" << endl;
+    for (const auto &fila : matrizScoresLocales(secs, *matriz)) {
+      for (int score : fila)
+        archivoSalida << setw(5) << score;
+      archivoSalida << endl;
+    }
+    archivoSalida << endl;
+  }
+  archivoSalida.close();
+  cout << "Scores locales guardados en " << nombreArchivo << endl;
+}
+
+// Alineamiento Estrella con el esquema de puntuacion elegido en tiempo de ejecucion
+ResultadoAlineamientoEstrella alineamientoEstrella(const vector<string> &secs, EsquemaPuntuacion esquema) {
+  switch (esquema) {
+  case EsquemaPuntuacion::Transiciones:
+    return alineamientoEstrella<PuntuacionTransiciones>(secs);
+  case EsquemaPuntuacion::Blastn:
+    return alineamientoEstrella<PuntuacionBlastn>(secs);
+  default:
+    return alineamientoEstrella<PuntuacionEstandar>(secs);
+  }
+}
+
 // Función para guardar los resultados del Alineamiento Estrella
 void guardarResultadosAlineamientoEstrella(const string &nombreArchivo, const ResultadoAlineamientoEstrella &resultado,
                                            const vector<string> &secs) {
@@ -252,8 +471,10 @@ void guardarResultadosAlineamientoEstrella(const string &nombreArchivo, const Re
         const auto &parejaAlineada = resultado.alineamientosConEstrella[conteosecsProcesadas];
         archivoSalida << "Alineamiento con S" << resultado.indiceSecCentralOriginal << " (estrella) y S" << i << " (" << secs[i]
                       << "):" << endl;
-        archivoSalida << "  Estrella: " << parejaAlineada.sec1Alineada << endl;
-        archivoSalida << "  Sec " << i << "    : " << parejaAlineada.sec2Alineada << endl;
+        pair<string, string> columnas =
+            parejaAlineada.cigar.expandir(secs[resultado.indiceSecCentralOriginal], secs[i]);
+        archivoSalida << "  Estrella: " << columnas.first << endl;
+        archivoSalida << "  Sec " << i << "    : " << columnas.second << endl;
         archivoSalida << "  score : " << parejaAlineada.score << endl << endl;
         conteosecsProcesadas++;
       }
@@ -288,5 +509,16 @@ int main() {
   cout << "\nProcesando Conjunto 2 de secs..." << endl;
   ResultadoAlineamientoEstrella resAlineamiento2 = alineamientoEstrella(secs2);
   guardarResultadosAlineamientoEstrella("alineamiento_estrella_2.txt", resAlineamiento2, secs2);
+
+  cout << "\nProcesando Conjunto 2 de secs con BLOSUM62..." << endl;
+  ResultadoAlineamientoEstrella resAlineamiento3 = alineamientoEstrella(secs2, BLOSUM62);
+  guardarResultadosAlineamientoEstrella("alineamiento_estrella_2_blosum62.txt", resAlineamiento3, secs2);
+
+  cout << "\nProcesando Conjunto 2 de secs con PAM250..." << endl;
+  ResultadoAlineamientoEstrella resAlineamiento4 = alineamientoEstrella(secs2, PAM250);
+  guardarResultadosAlineamientoEstrella("alineamiento_estrella_2_pam250.txt", resAlineamiento4, secs2);
+
+  cout << "\nScores locales del Conjunto 2..." << endl;
+  guardarScoresLocales("scores_locales_2.txt", secs2, {&BLOSUM62, &PAM250});
   return 0;
 }